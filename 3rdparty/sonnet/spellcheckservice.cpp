@@ -17,17 +17,23 @@
 #include "scritedocument.h"
 #include "garbagecollector.h"
 
+#include <QCache>
 #include <QFuture>
+#include <QThread>
 #include <QJsonObject>
+#include <QThreadPool>
 #include <QTimerEvent>
 #include <QFutureWatcher>
+#include <QFutureInterface>
+#include <QReadWriteLock>
+#include <QSharedPointer>
 #include <QThreadStorage>
 #include <QtConcurrentRun>
 #include <QRandomGenerator>
 #include <QCoreApplication>
 
-#include "3rdparty/sonnet/sonnet/src/core/speller.h"
 #include "3rdparty/sonnet/sonnet/src/core/loader_p.h"
+#include "3rdparty/sonnet/sonnet/src/core/spellerplugin_p.h"
 #include "3rdparty/sonnet/sonnet/src/core/textbreaks_p.h"
 #include "3rdparty/sonnet/sonnet/src/core/guesslanguage.h"
 
@@ -43,32 +49,240 @@ public:
     SpellCheckServiceResult() { padding[0] = 0; }
 
     int timestamp = -1;
+    int exclusionsGeneration = -1;
+    int dictionaryGeneration = -1;
     QString text;
     QList<TextFragment> misspelledFragments;
 };
 Q_DECLARE_METATYPE(SpellCheckServiceResult)
 
-class EnglishLanguageSpeller : public Sonnet::Speller
+/**
+ * Words repeat a lot across paragraphs of a screenplay, so the speller's verdict on each word
+ * is cached for use by all spell-check requests. Suggestions are looked up only for the word
+ * that the user asks them for, and the most recently used ones are kept around. The cache is
+ * cleared whenever a word is added to the personal dictionary, which also bumps its generation.
+ * Added words are remembered, so that spellers on all threads can learn about them.
+ */
+class SpellCheckWordCache
 {
 public:
+    static SpellCheckWordCache *instance()
+    {
+        static SpellCheckWordCache theInstance;
+        return &theInstance;
+    }
+
+    bool findVerdict(const QString &word, bool &misspelled) const
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_verdicts.constFind(word);
+        if (it == m_verdicts.constEnd())
+            return false;
+        misspelled = it.value();
+        return true;
+    }
+
+    // Verdicts and suggestions are inserted along with the generation that was current before
+    // the speller was asked for them. They are dropped if a word was added to the dictionary
+    // in the meantime, because they may have been computed before the speller knew about it.
+    void insertVerdict(const QString &word, bool misspelled, int generation)
+    {
+        QWriteLocker locker(&m_lock);
+        if (generation != m_generation)
+            return;
+        if (m_verdicts.size() >= 100000)
+            m_verdicts.clear();
+        m_verdicts.insert(word, misspelled);
+    }
+
+    bool findSuggestions(const QString &word, QStringList &suggestions)
+    {
+        // Looking up a QCache updates its usage order, hence the write lock.
+        QWriteLocker locker(&m_lock);
+        const QStringList *cachedSuggestions = m_suggestions.object(word);
+        if (cachedSuggestions == nullptr)
+            return false;
+        suggestions = *cachedSuggestions;
+        return true;
+    }
+
+    void insertSuggestions(const QString &word, const QStringList &suggestions, int generation)
+    {
+        QWriteLocker locker(&m_lock);
+        if (generation != m_generation)
+            return;
+        m_suggestions.insert(word, new QStringList(suggestions));
+    }
+
+    void addWord(const QString &word)
+    {
+        QWriteLocker locker(&m_lock);
+        m_verdicts.clear();
+        m_suggestions.clear();
+        m_addedWords.append(word);
+        ++m_generation;
+    }
+
+    QStringList addedWords(int from) const
+    {
+        QReadLocker locker(&m_lock);
+        return m_addedWords.mid(from);
+    }
+
+    int generation() const
+    {
+        QReadLocker locker(&m_lock);
+        return m_generation;
+    }
+
+private:
+    mutable QReadWriteLock m_lock;
+    QHash<QString, bool> m_verdicts;
+    QCache<QString, QStringList> m_suggestions = QCache<QString, QStringList>(256);
+    QStringList m_addedWords;
+    int m_generation = 0;
+};
+
+/**
+ * Sonnet::Speller shares one speller plugin per language across the whole program, which
+ * isn't safe to use from multiple threads at once. So, each spell-check thread creates a
+ * speller plugin of its own. Words added to the dictionary on one thread are added to the
+ * session of plugins on the other threads, before they check any more words.
+ */
+class EnglishLanguageSpeller
+{
+public:
+    EnglishLanguageSpeller()
+    {
 #ifdef Q_OS_MAC
-    EnglishLanguageSpeller() : Sonnet::Speller("en") { }
+        const QString language = QStringLiteral("en");
 #else
 #ifdef Q_OS_WIN
-    EnglishLanguageSpeller() : Sonnet::Speller() { }
+        const QString language; // default language
 #else
-    EnglishLanguageSpeller() : Sonnet::Speller("en_US") { }
+        const QString language = QStringLiteral("en_US");
 #endif
 #endif
+        Sonnet::Loader *loader = Sonnet::Loader::openLoader();
+        if (loader != nullptr)
+            m_plugin.reset(loader->createSpeller(language));
+    }
     ~EnglishLanguageSpeller() { }
+
+    bool isMisspelled(const QString &word)
+    {
+        this->syncAddedWords();
+        return m_plugin.isNull() ? false : m_plugin->isMisspelled(word);
+    }
+
+    QStringList suggest(const QString &word)
+    {
+        this->syncAddedWords();
+        return m_plugin.isNull() ? QStringList() : m_plugin->suggest(word);
+    }
+
+    bool addToPersonal(const QString &word)
+    {
+        if (m_plugin.isNull() || !m_plugin->addToPersonal(word))
+            return false;
+
+        SpellCheckWordCache::instance()->addWord(word);
+        return true;
+    }
+
+private:
+    void syncAddedWords()
+    {
+        SpellCheckWordCache *wordCache = SpellCheckWordCache::instance();
+        if (m_plugin.isNull() || wordCache->generation() == m_dictionaryGeneration)
+            return;
+
+        const QStringList addedWords = wordCache->addedWords(m_addedWordCount);
+        for (const QString &word : addedWords)
+            m_plugin->addToSession(word);
+
+        m_addedWordCount += addedWords.size();
+        m_dictionaryGeneration = wordCache->generation();
+    }
+
+private:
+    QScopedPointer<Sonnet::SpellerPlugin> m_plugin;
+    int m_addedWordCount = 0;
+    int m_dictionaryGeneration = 0;
 };
 
+static EnglishLanguageSpeller *ThreadSpeller()
+{
+    // Creating a speller loads its dictionary, so each spell-check thread creates one only once.
+    static QThreadStorage<EnglishLanguageSpeller *> spellers;
+    if (!spellers.hasLocalData())
+        spellers.setLocalData(new EnglishLanguageSpeller);
+    return spellers.localData();
+}
+
+/**
+ * Words that are not reported as misspelled, even if the speller says they are. Character names
+ * are case folded, because they are matched case insensitively. A new generation of exclusions
+ * is created only when the character names or the ignore list change.
+ */
+struct SpellCheckServiceExclusions
+{
+    int generation = 0;
+    QSet<QString> characterNames;
+    QSet<QString> ignoreList;
+
+    bool contains(const QString &word) const
+    {
+        if (ignoreList.contains(word))
+            return true;
+
+        if (characterNames.contains(word.toCaseFolded()))
+            return true;
+
+        if (word.endsWith(QStringLiteral("\'s"), Qt::CaseInsensitive))
+            return characterNames.contains(word.left(word.length() - 2).toCaseFolded());
+
+        return false;
+    }
+};
+
+static QSharedPointer<const SpellCheckServiceExclusions>
+SpellCheckServiceExclusionsFor(const QStringList &characterNames, const QStringList &ignoreList)
+{
+    static int generation = 0;
+    static QStringList lastCharacterNames;
+    static QStringList lastIgnoreList;
+    static QSharedPointer<const SpellCheckServiceExclusions> exclusions;
+
+    if (exclusions.isNull() || characterNames != lastCharacterNames
+        || ignoreList != lastIgnoreList) {
+        SpellCheckServiceExclusions *newExclusions = new SpellCheckServiceExclusions;
+        newExclusions->generation = ++generation;
+        newExclusions->characterNames.reserve(characterNames.size());
+        for (const QString &name : characterNames)
+            newExclusions->characterNames.insert(name.toCaseFolded());
+        newExclusions->ignoreList = QSet<QString>(ignoreList.begin(), ignoreList.end());
+
+        exclusions.reset(newExclusions);
+        lastCharacterNames = characterNames;
+        lastIgnoreList = ignoreList;
+    }
+
+    return exclusions;
+}
+
 struct SpellCheckServiceRequest
 {
     QString text;
     int timestamp;
-    QStringList characterNames;
-    QStringList ignoreList;
+    int dictionaryGeneration = -1;
+    QSharedPointer<const SpellCheckServiceExclusions> exclusions;
+
+    // Text checked previously and the fragments found in it. Only parts of text that differ
+    // from previousText need to be checked again.
+    bool incremental = false;
+    QString previousText;
+    QList<TextFragment> previousFragments;
 };
 Q_DECLARE_METATYPE(SpellCheckServiceRequest)
 
@@ -106,20 +320,64 @@ SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
      * Note and StructureElement also. This fits into the whole model-view thinking that
      * QML apps are required to leverage.
      *
-     * There is obviously room for improvement in this implementation. We could cache
-     * spell-check done in the previous round and only check for delta changes in here.
-     * But for now, we simply take a brute-force approach. But this function could be a
-     * good place for us to accept community contribution.
+     * Spell-check done in the previous round is reused, only words in the part of the
+     * paragraph that changed since then are checked again. Verdicts of the speller on
+     * each word are also cached across paragraphs in SpellCheckWordCache.
      */
 
-    const Sonnet::TextBreaks::Positions wordPositions =
-            Sonnet::TextBreaks::wordBreaks(request.text);
-    if (wordPositions.isEmpty() || Sonnet::Loader::openLoader() == nullptr)
+    if (Sonnet::Loader::openLoader() == nullptr || request.exclusions.isNull())
         return result;
 
-    EnglishLanguageSpeller speller;
+    // Only a complete spell-check can be built upon in the next round.
+    result.exclusionsGeneration = request.exclusions->generation;
+    result.dictionaryGeneration = request.dictionaryGeneration;
+
+    const QString &text = request.text;
+
+    int from = 0;
+    int to = text.length();
+    QList<TextFragment> fragmentsAfter;
+
+    if (request.incremental) {
+        const QString &previousText = request.previousText;
+
+        const int maxCommonLength = qMin(previousText.length(), text.length());
+        int prefixLength = 0;
+        while (prefixLength < maxCommonLength
+               && previousText.at(prefixLength) == text.at(prefixLength))
+            ++prefixLength;
+
+        int suffixLength = 0;
+        while (suffixLength < maxCommonLength - prefixLength
+               && previousText.at(previousText.length() - suffixLength - 1)
+                       == text.at(text.length() - suffixLength - 1))
+            ++suffixLength;
+
+        // Edited range is grown till whitespace on either side, so that no word is cut short.
+        from = prefixLength;
+        while (from > 0 && !text.at(from - 1).isSpace())
+            --from;
+
+        to = text.length() - suffixLength;
+        while (to < text.length() && !text.at(to).isSpace())
+            ++to;
+
+        const int delta = text.length() - previousText.length();
+        for (const TextFragment &fragment : request.previousFragments) {
+            if (fragment.end() < from)
+                result.misspelledFragments << fragment;
+            else if (fragment.start() >= to - delta)
+                fragmentsAfter << TextFragment(fragment.start() + delta, fragment.length());
+        }
+    }
+
+    const Sonnet::TextBreaks::Positions wordPositions =
+            Sonnet::TextBreaks::wordBreaks(text.mid(from, to - from));
+
+    EnglishLanguageSpeller *speller = ThreadSpeller();
+    SpellCheckWordCache *wordCache = SpellCheckWordCache::instance();
     for (const Sonnet::TextBreaks::Position &wordPosition : wordPositions) {
-        const QString word = request.text.mid(wordPosition.start, wordPosition.length);
+        const QString word = text.mid(from + wordPosition.start, wordPosition.length);
         if (word.isEmpty())
             continue; // not sure why this would happen, but just keeping safe.
 
@@ -131,32 +389,24 @@ SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
             continue;
 #endif
 
-        if (Sonnet::Loader::openLoader() == nullptr) {
-            result.misspelledFragments.clear();
-            break;
+        bool misspelled = false;
+        if (!wordCache->findVerdict(word, misspelled)) {
+            const int generation = wordCache->generation();
+            misspelled = speller->isMisspelled(word);
+            wordCache->insertVerdict(word, misspelled, generation);
         }
 
-        const bool misspelled = speller.isMisspelled(word);
-        if (misspelled) {
-            if (request.ignoreList.contains(word))
-                continue;
-
-            if (request.characterNames.contains(word, Qt::CaseInsensitive))
-                continue;
-
-            if (word.endsWith("\'s", Qt::CaseInsensitive)) {
-                if (request.characterNames.contains(word.leftRef(word.length() - 2),
-                                                    Qt::CaseInsensitive))
-                    continue;
-            }
+        if (!misspelled || request.exclusions->contains(word))
+            continue;
 
-            const QStringList suggestions = speller.suggest(word);
-            TextFragment fragment(wordPosition.start, wordPosition.length, suggestions);
-            if (fragment.isValid())
-                result.misspelledFragments << fragment;
-        }
+        // Suggestions are looked up later, only if they are asked for.
+        TextFragment fragment(from + wordPosition.start, wordPosition.length);
+        if (fragment.isValid())
+            result.misspelledFragments << fragment;
     }
 
+    result.misspelledFragments += fragmentsAfter;
+
     return result;
 }
 
@@ -165,8 +415,7 @@ bool AddToDictionary(const QString &word)
     /**
      * It is assumed that word contains a single word. We won't bother checking for that.
      */
-    EnglishLanguageSpeller speller;
-    return speller.addToPersonal(word);
+    return ThreadSpeller()->addToPersonal(word);
 }
 
 QStringList GetSpellingSuggestions(const QString &word)
@@ -174,15 +423,17 @@ QStringList GetSpellingSuggestions(const QString &word)
     /**
      * It is assumed that word contains a single word. We won't bother checking for that.
      */
-    EnglishLanguageSpeller speller;
-    return speller.suggest(word);
+    SpellCheckWordCache *wordCache = SpellCheckWordCache::instance();
+    const int generation = wordCache->generation();
+    const QStringList suggestions = ThreadSpeller()->suggest(word);
+    wordCache->insertSuggestions(word, suggestions, generation);
+    return suggestions;
 }
 
 static QThreadPool *SpellCheckServiceThreadPool()
 {
     /**
-     * We make use of QtConcurrent::run() method to schedule the following methods on a
-     * background thread, so that they dont block the UI.
+     * We schedule the following methods on background threads, so that they dont block the UI.
      * - InitializeSpellCheckThread
      * - CheckSpellings
      * - AddToDictionary
@@ -193,9 +444,12 @@ static QThreadPool *SpellCheckServiceThreadPool()
      * to looup spellings asynchronously and in the background. So, scheduling these
      * functions in a background thread works for us.
      *
-     * Moreover we need exactly one thread for this purpose. While a QThreadPool can
-     * allocate multiple threads for us, we need only one. And one that thread is created
-     * it should NEVER EVER terminate until the program finishes.
+     * Spell-checks are spread across a few threads, each of which has its own speller. Once
+     * a thread is created it should NEVER EVER terminate until the program finishes, because
+     * that would mean loading dictionaries all over again.
+     *
+     * On macOS, all spellers talk to the one shared NSSpellChecker. So we use exactly one
+     * thread there.
      */
     static bool initialized = false;
     static QThreadPool threadPool;
@@ -203,9 +457,11 @@ static QThreadPool *SpellCheckServiceThreadPool()
 #ifdef Q_OS_MAC
         // Lookup documentation of this function to see why we are doing this.
         NSSpellCheckerClient::ensureSpellCheckerAvailability();
+        threadPool.setMaxThreadCount(1);
+#else
+        threadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
 #endif
         threadPool.setExpiryTimeout(-1);
-        threadPool.setMaxThreadCount(1);
         QFuture<void> future = QtConcurrent::run(&threadPool, InitializeSpellCheckThread);
         future.waitForFinished();
         initialized = true;
@@ -214,6 +470,49 @@ static QThreadPool *SpellCheckServiceThreadPool()
     return &threadPool;
 }
 
+/**
+ * Spell-check work is queued in SpellCheckServiceThreadPool() with one of these priorities.
+ * Requests that the UI waits for are run first. Paragraphs that the user is working on are
+ * checked before any other paragraph.
+ */
+enum SpellCheckServiceTaskPriority {
+    BackgroundTaskPriority = 0,
+    ForegroundTaskPriority = 1,
+    BlockingTaskPriority = 2
+};
+
+template<class T>
+class SpellCheckServiceTask : public QRunnable
+{
+public:
+    static QFuture<T> start(SpellCheckServiceTaskPriority priority,
+                            const std::function<T()> &function)
+    {
+        QThreadPool *threadPool = SpellCheckServiceThreadPool();
+
+        SpellCheckServiceTask<T> *task = new SpellCheckServiceTask<T>(function);
+        const QFuture<T> future = task->m_futureInterface.future();
+        threadPool->start(task, priority);
+        return future;
+    }
+
+    void run()
+    {
+        m_futureInterface.reportResult(m_function());
+        m_futureInterface.reportFinished();
+    }
+
+private:
+    SpellCheckServiceTask(const std::function<T()> &function) : m_function(function)
+    {
+        m_futureInterface.reportStarted();
+    }
+
+private:
+    std::function<T()> m_function;
+    QFutureInterface<T> m_futureInterface;
+};
+
 SpellCheckService::SpellCheckService(QObject *parent)
     : QObject(parent), m_textTracker(&m_textModifiable)
 {
@@ -227,7 +526,7 @@ void SpellCheckService::setText(const QString &val)
         return;
 
     m_text = val;
-    m_textModifiable.markAsModified();
+    this->markTextAsModified();
 
     emit textChanged();
 
@@ -243,6 +542,15 @@ void SpellCheckService::setMethod(SpellCheckService::Method val)
     emit methodChanged();
 }
 
+void SpellCheckService::setPriority(Priority val)
+{
+    if (m_priority == val)
+        return;
+
+    m_priority = val;
+    emit priorityChanged();
+}
+
 void SpellCheckService::setAsynchronous(bool val)
 {
     if (m_asynchronous == val)
@@ -261,7 +569,7 @@ void SpellCheckService::scheduleUpdate()
         return;
     }
 
-    m_textModifiable.markAsModified();
+    this->markTextAsModified();
     m_updateTimer.start(500, this);
 }
 
@@ -276,8 +584,7 @@ void SpellCheckService::update()
 
     this->setMisspelledFragments(QList<TextFragment>());
 
-    QThreadPool *threadPool = SpellCheckServiceThreadPool();
-    if (threadPool == nullptr || m_text.isEmpty()) {
+    if (m_text.isEmpty()) {
         emit finished();
         return;
     }
@@ -290,41 +597,107 @@ void SpellCheckService::update()
     static int serviceRequestTypeId = qRegisterMetaType<SpellCheckServiceRequest>();
     Q_UNUSED(serviceRequestTypeId)
 
+    QStringList characterNames = ScriteDocument::instance()->structure()->characterNames();
+    characterNames << QStringLiteral("Rajkumar");
+
     SpellCheckServiceRequest request;
     request.text = m_text;
     request.timestamp = m_textModifiable.modificationTime();
-    request.characterNames = ScriteDocument::instance()->structure()->characterNames();
-    request.ignoreList = ScriteDocument::instance()->spellCheckIgnoreList();
-
-    request.characterNames << QStringLiteral("Rajkumar");
+    request.dictionaryGeneration = SpellCheckWordCache::instance()->generation();
+    request.exclusions = SpellCheckServiceExclusionsFor(
+            characterNames, ScriteDocument::instance()->spellCheckIgnoreList());
+
+    // Results of the previous spell-check hold only if the same words were excluded from it,
+    // and the dictionary hasn't changed since.
+    request.incremental = m_checkedExclusionsGeneration == request.exclusions->generation
+            && m_checkedDictionaryGeneration == request.dictionaryGeneration;
+    if (request.incremental) {
+        request.previousText = m_checkedText;
+        request.previousFragments = m_checkedFragments;
+    }
 
     QFutureWatcher<SpellCheckServiceResult> *watcher =
             new QFutureWatcher<SpellCheckServiceResult>(this);
     connect(watcher, SIGNAL(finished()), this, SLOT(spellCheckComplete()), Qt::QueuedConnection);
 
-    QFuture<SpellCheckServiceResult> future =
-            QtConcurrent::run(threadPool, CheckSpellings, request);
+    // Requests that are outdated by the time they get their turn aren't worth running.
+    const QSharedPointer<QAtomicInt> textTimestamp = m_textTimestamp;
+    QFuture<SpellCheckServiceResult> future = SpellCheckServiceTask<SpellCheckServiceResult>::start(
+            m_priority == ForegroundPriority ? ForegroundTaskPriority : BackgroundTaskPriority,
+            [request, textTimestamp]() {
+                if (textTimestamp->loadAcquire() != request.timestamp) {
+                    SpellCheckServiceResult result;
+                    result.timestamp = request.timestamp;
+                    return result;
+                }
+
+                return CheckSpellings(request);
+            });
     watcher->setFuture(future);
 }
 
 QStringList SpellCheckService::suggestions(const QString &word)
 {
-    QThreadPool *threadPool = SpellCheckServiceThreadPool();
-    if (threadPool == nullptr)
-        return QStringList();
+    QStringList ret;
+    if (SpellCheckWordCache::instance()->findSuggestions(word, ret))
+        return ret;
 
-    QFuture<QStringList> future = QtConcurrent::run(threadPool, GetSpellingSuggestions, word);
+    QFuture<QStringList> future = SpellCheckServiceTask<QStringList>::start(
+            BlockingTaskPriority, [word]() { return GetSpellingSuggestions(word); });
     future.waitForFinished();
     return future.result();
 }
 
-bool SpellCheckService::addToDictionary(const QString &word)
+QFuture<QStringList> SpellCheckService::lookupSuggestions(const QString &word)
 {
-    QThreadPool *threadPool = SpellCheckServiceThreadPool();
-    if (threadPool == nullptr)
-        return false;
+    // Cached suggestions are handed out in a future that has already finished, so that
+    // callers can use them right away instead of waiting for a watcher to report them.
+    QStringList ret;
+    if (SpellCheckWordCache::instance()->findSuggestions(word, ret)) {
+        QFutureInterface<QStringList> futureInterface;
+        futureInterface.reportStarted();
+        futureInterface.reportResult(ret);
+        futureInterface.reportFinished();
+        return futureInterface.future();
+    }
+
+    return SpellCheckServiceTask<QStringList>::start(
+            ForegroundTaskPriority, [word]() { return GetSpellingSuggestions(word); });
+}
+
+void SpellingSuggestionsLookup::lookup(const QString &word, QObject *context,
+                                       const std::function<void(const QStringList &)> &callback)
+{
+    if (m_word == word)
+        return;
+
+    m_word = word;
+    if (word.isEmpty()) {
+        callback(QStringList());
+        return;
+    }
+
+    QFuture<QStringList> future = SpellCheckService::lookupSuggestions(word);
+    if (future.isFinished()) {
+        callback(future.result());
+        return;
+    }
+
+    callback(QStringList());
+
+    QFutureWatcher<QStringList> *watcher = new QFutureWatcher<QStringList>(context);
+    QObject::connect(watcher, &QFutureWatcher<QStringList>::finished, context, [=]() {
+        if (m_word == word)
+            callback(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
 
-    QFuture<bool> future = QtConcurrent::run(threadPool, AddToDictionary, word);
+bool SpellCheckService::addToDictionary(const QString &word)
+{
+    QFuture<bool> future = SpellCheckServiceTask<bool>::start(
+            BlockingTaskPriority, [word]() { return AddToDictionary(word); });
     future.waitForFinished();
     return future.result();
 }
@@ -370,6 +743,12 @@ void SpellCheckService::doUpdate()
     }
 }
 
+void SpellCheckService::markTextAsModified()
+{
+    m_textModifiable.markAsModified();
+    m_textTimestamp->storeRelease(m_textModifiable.modificationTime());
+}
+
 void SpellCheckService::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_updateTimer.timerId())
@@ -394,6 +773,11 @@ void SpellCheckService::spellCheckComplete()
 
 void SpellCheckService::acceptResult(const SpellCheckServiceResult &result)
 {
+    m_checkedText = result.text;
+    m_checkedFragments = result.misspelledFragments;
+    m_checkedExclusionsGeneration = result.exclusionsGeneration;
+    m_checkedDictionaryGeneration = result.dictionaryGeneration;
+
     this->setMisspelledFragments(result.misspelledFragments);
     emit finished();
 }
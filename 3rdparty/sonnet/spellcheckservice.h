@@ -14,25 +14,23 @@
 #ifndef SPELL_CHECK_SERVICE_H
 #define SPELL_CHECK_SERVICE_H
 
+#include <QFuture>
 #include <QObject>
 #include <QQmlEngine>
 #include <QJsonArray>
+#include <QSharedPointer>
 #include <QQmlParserStatus>
 
 #include "modifiable.h"
 #include "execlatertimer.h"
 
+// Suggestions for a misspelled fragment are looked up with SpellCheckService::suggestions(),
+// or without blocking with SpellCheckService::lookupSuggestions()
 struct TextFragment
 {
     TextFragment() { }
-    TextFragment(const TextFragment &other)
-        : m_start(other.m_start), m_length(other.m_length), m_suggestions(other.m_suggestions)
-    {
-    }
-    TextFragment(int s, int l, const QStringList &slist)
-        : m_start(s), m_length(l), m_suggestions(slist)
-    {
-    }
+    TextFragment(const TextFragment &other) : m_start(other.m_start), m_length(other.m_length) { }
+    TextFragment(int s, int l) : m_start(s), m_length(l) { }
 
     int start() const { return m_start; }
     int length() const { return m_length; }
@@ -40,22 +38,18 @@ struct TextFragment
     bool isValid() const { return m_length > 0 && m_start >= 0; }
     bool operator==(const TextFragment &other) const
     {
-        return m_start == other.m_start && m_length == other.m_length
-                && m_suggestions == other.m_suggestions;
+        return m_start == other.m_start && m_length == other.m_length;
     }
     TextFragment &operator=(const TextFragment &other)
     {
         m_start = other.m_start;
         m_length = other.m_length;
-        m_suggestions = other.m_suggestions;
         return *this;
     }
-    QStringList suggestions() const { return m_suggestions; }
 
 private:
     int m_start = -1;
     int m_length = 0;
-    QStringList m_suggestions;
 };
 Q_DECLARE_METATYPE(TextFragment)
 
@@ -93,6 +87,14 @@ public:
     } // for C++ access
     Q_SIGNAL void misspelledFragmentsChanged();
 
+    // Foreground spell-checks are run before background ones, whenever both are queued.
+    enum Priority { BackgroundPriority, ForegroundPriority };
+    Q_ENUM(Priority)
+    Q_PROPERTY(Priority priority READ priority WRITE setPriority NOTIFY priorityChanged)
+    void setPriority(Priority val);
+    Priority priority() const { return m_priority; }
+    Q_SIGNAL void priorityChanged();
+
     Q_PROPERTY(bool asynchronous READ isAsynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
     void setAsynchronous(bool val);
     bool isAsynchronous() const { return m_asynchronous; }
@@ -102,6 +104,7 @@ public:
     Q_INVOKABLE void update();
 
     static QStringList suggestions(const QString &word);
+    static QFuture<QStringList> lookupSuggestions(const QString &word);
     static bool addToDictionary(const QString &word);
 
     // QQmlParserStatus interface
@@ -115,6 +118,7 @@ signals:
 private:
     void setMisspelledFragments(const QList<TextFragment> &val);
     void doUpdate();
+    void markTextAsModified();
     void timerEvent(QTimerEvent *event);
     Q_SLOT void spellCheckComplete();
     void acceptResult(const SpellCheckServiceResult &result);
@@ -122,13 +126,36 @@ private:
 private:
     QString m_text;
     Method m_method = OnDemand;
+    Priority m_priority = BackgroundPriority;
     bool m_asynchronous = true;
     bool m_requiresSpellCheck = false;
     ExecLaterTimer m_updateTimer;
     Modifiable m_textModifiable;
     ModificationTracker m_textTracker;
+    QSharedPointer<QAtomicInt> m_textTimestamp = QSharedPointer<QAtomicInt>::create(0);
     QJsonArray m_misspelledFragmentsJson;
     QList<TextFragment> m_misspelledFragments;
+
+    // Outcome of the last spell-check, which the next one builds upon.
+    QString m_checkedText;
+    QList<TextFragment> m_checkedFragments;
+    int m_checkedExclusionsGeneration = -1;
+    int m_checkedDictionaryGeneration = -1;
+};
+
+/**
+ * Looks up suggestions for the word under a cursor without blocking. The callback gets them
+ * right away if they are cached, otherwise once they arrive, unless another word was looked up
+ * in the meantime. The lookup must be owned by the context object.
+ */
+class SpellingSuggestionsLookup
+{
+public:
+    void lookup(const QString &word, QObject *context,
+                const std::function<void(const QStringList &)> &callback);
+
+private:
+    QString m_word;
 };
 
 #endif // SPELL_CHECK_SERVICE_H
@@ -237,6 +237,7 @@ Rectangle {
 
                 Item {
                     property string searchString
+                    property int searchFlags: 0
                     property var searchResults: []
                     property int previousSceneIndex: -1
 
@@ -244,7 +245,7 @@ Rectangle {
 
                     SearchAgent.onReplaceAll: {
                         Runtime.screenplayTextDocument.syncEnabled = false
-                        Runtime.screenplayAdapter.screenplay.replace(searchString, replacementText, 0)
+                        Runtime.screenplayAdapter.screenplay.replace(searchString, replacementText, searchFlags)
                         Runtime.screenplayTextDocument.syncEnabled = true
                     }
                     SearchAgent.onReplaceCurrent: replaceCurrentRequest(replacementText)
@@ -253,7 +254,8 @@ Rectangle {
 
                     SearchAgent.onSearchRequest: {
                         searchString = string
-                        searchResults = Runtime.screenplayAdapter.screenplay.search(string, 0)
+                        searchFlags = searchBar.searchEngine.searchFlags
+                        searchResults = Runtime.screenplayAdapter.screenplay.search(string, searchFlags)
                         SearchAgent.searchResultCount = searchResults.length
                     }
 
@@ -267,6 +269,7 @@ Rectangle {
                             var screenplayElement = Runtime.screenplayAdapter.screenplay.elementAt(sceneIndex)
                             var data = {
                                 "searchString": searchString,
+                                "searchFlags": searchFlags,
                                 "sceneResultIndex": sceneResultIndex,
                                 "currentSearchResultIndex": SearchAgent.currentSearchResultIndex,
                                 "searchResultCount": SearchAgent.searchResultCount
@@ -2810,6 +2813,7 @@ Rectangle {
                     TextDocumentSearch {
                         id: textDocumentSearch
                         textDocument: sceneTextEditor.textDocument
+                        searchFlags: contentItem.theElement.userData ? contentItem.theElement.userData.searchFlags : 0
                         searchString: sceneDocumentBinder.documentLoadCount > 0 ? (contentItem.theElement.userData ? contentItem.theElement.userData.searchString : "") : ""
                         currentResultIndex: searchResultCount > 0 ? (contentItem.theElement.userData ? contentItem.theElement.userData.sceneResultIndex : -1) : -1
                         onHighlightText: selection = {"start": start, "end": end}
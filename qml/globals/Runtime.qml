@@ -590,6 +590,7 @@ Item {
         listSceneCharacters: false
         includeSceneSynopsis: false
         printEachSceneOnANewPage: false
+        layoutInBackground: true
         secondsPerPage: Scrite.document.printFormat.secondsPerPage
 
         // FIXME: Do we really need this?
@@ -128,6 +128,13 @@ Item {
                             checked: searchEngine.isSearchWholeWords
                             onToggled: searchEngine.isSearchWholeWords = checked
                         }
+
+                        VclMenuItem {
+                            text: "Regular Expression"
+                            checkable: true
+                            checked: searchEngine.isSearchRegularExpression
+                            onToggled: searchEngine.isSearchRegularExpression = checked
+                        }
                     }
                 }
 
@@ -89,7 +89,7 @@ SpellingSuggestionsMenu {
                        if(!textArea.hasSelection) {
                            textArea.cursorPosition = textArea.positionAt(mouse.x, mouse.y)
                            if(_private.highlighter.wordUnderCursorIsMisspelled) {
-                               root.spellingSuggestions = _private.highlighter.spellingSuggestionsForWordUnderCursor
+                               root.spellingSuggestions = _private.highlighter.spellingSuggestionsForWordAt(textArea.cursorPosition)
                                root.popup()
                                mouse.accepted = true
                                return
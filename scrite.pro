@@ -128,9 +128,11 @@ HEADERS += \
     src/reports/locationreport.h \
     src/reports/notebookreport.h \
     src/reports/scenecharactermatrixreport.h \
+    src/reports/scenepresencematrix.h \
     src/reports/statisticsreport.h \
     src/reports/statisticsreport_p.h \
     src/utils/execlatertimer.h \
+    src/utils/invalidationscheduler.h \
     src/utils/fountain.h \
     src/utils/graphlayout.h \
     src/utils/garbagecollector.h \
@@ -148,6 +150,7 @@ HEADERS += \
     src/document/undoredo.h \
     src/document/screenplayadapter.h \
     src/document/screenplay.h \
+    src/document/screenplaysearchindex.h \
     src/document/scene.h \
     src/core/application.h \
     src/core/autoupdate.h \
@@ -262,9 +265,11 @@ SOURCES += \
     src/reports/locationreport.cpp \
     src/reports/notebookreport.cpp \
     src/reports/scenecharactermatrixreport.cpp \
+    src/reports/scenepresencematrix.cpp \
     src/reports/statisticsreport.cpp \
     src/reports/statisticsreport_p.cpp \
     src/utils/execlatertimer.cpp \
+    src/utils/invalidationscheduler.cpp \
     src/utils/fountain.cpp \
     src/utils/genericarraymodel.cpp \
     src/utils/graphlayout.cpp \
@@ -272,6 +277,7 @@ SOURCES += \
     src/utils/qobjectserializer.cpp \
     src/document/scritedocument.cpp \
     src/document/screenplay.cpp \
+    src/document/screenplaysearchindex.cpp \
     src/document/scene.cpp \
     src/document/documentfilesystem.cpp \
     src/document/structure.cpp \
@@ -326,11 +332,16 @@ RESOURCES += \
 exists(../profilingtools/timeprofiler.cpp) {
     HEADERS += ../profilingtools/timeprofiler.h
     SOURCES += ../profilingtools/timeprofiler.cpp
+} else {
+    HEADERS += src/utils/timeprofiler.h
+    SOURCES += src/utils/timeprofiler.cpp
 }
 
 exists(../profilingtools/callgraph.cpp) {
     HEADERS += ../profilingtools/callgraph.h
     SOURCES += ../profilingtools/callgraph.cpp
+} else {
+    HEADERS += src/utils/callgraph.h
 }
 
 # https://doc.qt.io/qt-5/qtwebengine-deploying.html#javascript-files-in-qt-resource-files
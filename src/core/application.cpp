@@ -18,6 +18,7 @@
 #include "application.h"
 #include "notification.h"
 #include "localstorage.h"
+#include "timeprofiler.h"
 #include "scritedocument.h"
 
 #ifdef ENABLE_CRASHPAD_CRASH_TEST
@@ -204,6 +205,9 @@ Application::Application(int &argc, char **argv, const QVersionNumber &version)
     }();
     this->computeIdealFontPointSize();
 
+    if (m_settings->value(QStringLiteral("Application/enableProfiler"), false).toBool())
+        TimeProfiler::setEnabled(true);
+
     QSurfaceFormat surfaceFormat = QSurfaceFormat::defaultFormat();
     const QByteArray envOpenGLMultisampling =
             qgetenv("SCRITE_OPENGL_MULTISAMPLING").toUpper().trimmed();
@@ -372,6 +376,17 @@ QVersionNumber Application::prepare()
 
 Application::~Application()
 {
+    if (TimeProfiler::isEnabled()) {
+        const QString report = TimeProfiler::statisticsReport();
+        if (!report.isEmpty())
+            qInfo().noquote() << "Profiler Report:\n" << report;
+
+        const QString traceFile =
+                QString::fromLocal8Bit(qgetenv("SCRITE_PROFILER_TRACE")).trimmed();
+        if (!traceFile.isEmpty())
+            TimeProfiler::dumpTrace(traceFile);
+    }
+
 #ifndef QT_NO_DEBUG_OUTPUT
     QInternal::unregisterCallback(QInternal::EventNotifyCallback,
                                   QtApplicationEventNotificationCallback);
@@ -441,6 +456,32 @@ void Application::setCustomFontPointSize(int val)
     this->computeIdealFontPointSize();
 }
 
+void Application::setProfilerEnabled(bool val)
+{
+    if (TimeProfiler::isEnabled() == val)
+        return;
+
+    TimeProfiler::setEnabled(val);
+    m_settings->setValue(QLatin1String("Application/enableProfiler"), val);
+
+    emit profilerEnabledChanged();
+}
+
+bool Application::isProfilerEnabled() const
+{
+    return TimeProfiler::isEnabled();
+}
+
+bool Application::dumpProfilerTrace(const QString &fileName)
+{
+    return TimeProfiler::dumpTrace(fileName);
+}
+
+QString Application::profilerReport()
+{
+    return TimeProfiler::statisticsReport();
+}
+
 QUrl Application::toHttpUrl(const QUrl &url) const
 {
     if (url.scheme() != QStringLiteral("https"))
@@ -78,6 +78,18 @@ public:
     int customFontPointSize() const { return m_customFontPointSize; }
     Q_SIGNAL void customFontPointSizeChanged();
 
+    // Profiling can also be switched on by setting SCRITE_PROFILER=YES in the
+    // environment. In that case SCRITE_PROFILER_TRACE can name a file into which
+    // the trace is dumped on exit.
+    Q_PROPERTY(bool profilerEnabled READ isProfilerEnabled WRITE setProfilerEnabled NOTIFY
+                       profilerEnabledChanged)
+    void setProfilerEnabled(bool val);
+    bool isProfilerEnabled() const;
+    Q_SIGNAL void profilerEnabledChanged();
+
+    Q_INVOKABLE static bool dumpProfilerTrace(const QString &fileName);
+    Q_INVOKABLE static QString profilerReport();
+
     Q_INVOKABLE QUrl localFileToUrl(const QString &fileName) const
     {
         return QUrl::fromLocalFile(fileName);
@@ -757,6 +757,7 @@ void CharacterRelationshipGraph::load()
             GraphLayout::ForceDirectedLayout layout;
             layout.setMaxTime(m_maxTime);
             layout.setMaxIterations(m_maxIterations);
+            layout.setParallelForces(true);
             layout.setMinimumEdgeLength(fm.horizontalAdvance(longestRelationshipName) * 0.5);
             layout.layout(graph);
         }
@@ -12,14 +12,19 @@
 ****************************************************************************/
 
 #include "documentfilesystem.h"
+#include "timeprofiler.h"
 
 #include <QDir>
+#include <QSet>
 #include <QtDebug>
 #include <QDateTime>
+#include <QSaveFile>
+#include <QCborMap>
+#include <QCborValue>
 #include <QDataStream>
+#include <QJsonDocument>
 #include <QTemporaryDir>
 #include <QFutureWatcher>
-#include <QStandardPaths>
 #include <QtConcurrentRun>
 
 #include "quazip.h"
@@ -27,6 +32,56 @@
 #include "simplecrypt.h"
 #include "restapikey/restapikey.h"
 
+struct DocumentFileSystemFileStamp
+{
+    qint64 size = -1;
+    QDateTime lastModified;
+
+    static DocumentFileSystemFileStamp of(const QFileInfo &fi)
+    {
+        DocumentFileSystemFileStamp ret;
+        if (fi.exists()) {
+            ret.size = fi.size();
+            ret.lastModified = fi.lastModified();
+        }
+        return ret;
+    }
+
+    bool isValid() const { return size >= 0; }
+
+    bool operator==(const DocumentFileSystemFileStamp &other) const
+    {
+        return this->size == other.size && this->lastModified == other.lastModified;
+    }
+    bool operator!=(const DocumentFileSystemFileStamp &other) const { return !(*this == other); }
+};
+
+/**
+ * Keeps track of the archive on disk whose entries mirror files in the DFS folder,
+ * as of the last load or save. While saving, entries whose files have not changed
+ * since then are copied over from this archive without being inflated and
+ * compressed again.
+ */
+struct DocumentFileSystemArchive
+{
+    QString fileName;
+    DocumentFileSystemFileStamp stamp;
+    QHash<QString, DocumentFileSystemFileStamp> entries;
+
+    bool isValid() const
+    {
+        return !fileName.isEmpty() && stamp.isValid()
+                && stamp == DocumentFileSystemFileStamp::of(QFileInfo(fileName));
+    }
+
+    void reset()
+    {
+        fileName.clear();
+        stamp = DocumentFileSystemFileStamp();
+        entries.clear();
+    }
+};
+
 struct DocumentFileSystemData
 {
     QByteArray header;
@@ -35,11 +90,22 @@ struct DocumentFileSystemData
     QScopedPointer<QTemporaryDir> folder;
     qint64 fileNameCounter = 0;
 
+    // Archive state is accessed only while folderMutex is locked. Dirty paths are
+    // collected on the calling thread, and handed over to the save task.
+    DocumentFileSystemArchive archive;
+    QSet<QString> dirtyPaths;
+
     static const QString normalHeaderFile;
     static const QString encryptedHeaderFile;
 
     void pack(QDataStream &ds, const QString &path);
 
+    void markDirty(const QString &absPath)
+    {
+        if (!absPath.isEmpty())
+            dirtyPaths += QDir(folder->path()).relativeFilePath(absPath);
+    }
+
     QStringList filePaths() const
     {
         QStringList ret;
@@ -144,6 +210,8 @@ void DocumentFileSystem::reset()
     }
 
     d->folder.reset(new QTemporaryDir);
+    d->archive.reset();
+    d->dirtyPaths.clear();
 
 #ifndef QT_NO_DEBUG_OUTPUT_OUTPUT
     qDebug() << "PA: " << d->folder->path();
@@ -205,8 +273,129 @@ bool doUnzip(const QFileInfo &fileInfo, const QTemporaryDir &dstDir)
     return true;
 }
 
+QByteArray doUnzipFile(const QString &zipFileName, const QString &entryName)
+{
+    // QuaZip reads only the central directory on open(), and setCurrentFile()
+    // looks up the entry there. So only the requested entry gets inflated.
+    QuaZip qzip(zipFileName);
+    qzip.setUtf8Enabled(true);
+    if (!qzip.open(QuaZip::mdUnzip))
+        return QByteArray();
+
+    if (!qzip.setCurrentFile(entryName, QuaZip::csSensitive)) {
+        qzip.close();
+        return QByteArray();
+    }
+
+    QByteArray ret;
+
+    QuaZipFile srcFile(&qzip);
+    if (srcFile.open(QFile::ReadOnly)) {
+        ret = srcFile.readAll();
+        srcFile.close();
+    }
+
+    qzip.close();
+
+    return ret;
+}
+
+QByteArray doUnpackFile(QDataStream &ds, const QString &entryName)
+{
+    // Skips over files in the older Scrite format, until the requested one is found.
+    while (!ds.atEnd()) {
+        QString relativeFilePath;
+        ds >> relativeFilePath;
+
+        qint64 fileSize = 0;
+        ds >> fileSize;
+
+        if (ds.status() != QDataStream::Ok || fileSize < 0)
+            break;
+
+        if (relativeFilePath == entryName)
+            return ds.device()->read(fileSize);
+
+        if (fileSize > 0 && !ds.device()->seek(ds.device()->pos() + fileSize))
+            break;
+    }
+
+    return QByteArray();
+}
+
+QByteArray DocumentFileSystem::peekHeader(const QString &fileName, Format *format)
+{
+    if (format)
+        *format = UnknownFormat;
+
+    if (fileName.isEmpty())
+        return QByteArray();
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+
+    const int markerLength = ::DocumentFileSystemMaker->length();
+    const QByteArray marker = file.read(markerLength);
+    if (marker == *::DocumentFileSystemMaker) {
+        QDataStream ds(&file);
+
+        QByteArray compressedHeader;
+        ds >> compressedHeader;
+
+        if (format)
+            *format = ScriteFormat;
+
+        return compressedHeader.isEmpty() ? compressedHeader : qUncompress(compressedHeader);
+    }
+
+    file.close();
+
+    QByteArray header = doUnzipFile(fileName, DocumentFileSystemData::normalHeaderFile);
+    if (header.isEmpty()) {
+        const QByteArray headerData =
+                doUnzipFile(fileName, DocumentFileSystemData::encryptedHeaderFile);
+        if (!headerData.isEmpty()) {
+            SimpleCrypt sc(REST_CRYPT_KEY);
+            header = sc.decryptToByteArray(headerData);
+        }
+    }
+
+    if (format && !header.isEmpty())
+        *format = ZipFormat;
+
+    return header;
+}
+
+QByteArray DocumentFileSystem::peekFile(const QString &fileName, const QString &path)
+{
+    if (fileName.isEmpty() || path.isEmpty() || QDir::isAbsolutePath(path))
+        return QByteArray();
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+
+    const int markerLength = ::DocumentFileSystemMaker->length();
+    const QByteArray marker = file.read(markerLength);
+    if (marker == *::DocumentFileSystemMaker) {
+        QDataStream ds(&file);
+
+        QByteArray compressedHeader;
+        ds >> compressedHeader;
+
+        return doUnpackFile(ds, path);
+    }
+
+    file.close();
+
+    return doUnzipFile(fileName, path);
+}
+
 bool DocumentFileSystem::load(const QString &fileName, Format *format)
 {
+    PROFILE_THIS_FUNCTION;
+
     QMutexLocker mutexLocker(&d->folderMutex);
 
 #ifndef QT_NO_DEBUG_OUTPUT_OUTPUT
@@ -263,23 +452,119 @@ bool DocumentFileSystem::load(const QString &fileName, Format *format)
 
         if (format)
             *format = ZipFormat;
+
+        // Remember what was extracted, so that the next save can carry over
+        // unchanged entries from this file.
+        d->archive.fileName = QFileInfo(fileName).absoluteFilePath();
+        d->archive.stamp = DocumentFileSystemFileStamp::of(QFileInfo(d->archive.fileName));
+
+        const QDir folderDir(d->folder->path());
+        const QStringList filePaths = d->filePaths();
+        for (const QString &filePath : filePaths)
+            d->archive.entries.insert(filePath,
+                                      DocumentFileSystemFileStamp::of(
+                                              QFileInfo(folderDir.absoluteFilePath(filePath))));
     }
 
     return !d->header.isEmpty();
 }
 
-void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip)
+bool doCopyRawEntry(QuaZip &srcZip, const QString &entryName, QuaZip &qzip)
+{
+    if (!srcZip.setCurrentFile(entryName, QuaZip::csSensitive))
+        return false;
+
+    QuaZipFileInfo64 qfileInfo;
+    if (!srcZip.getCurrentFileInfo(&qfileInfo))
+        return false;
+
+    int method = 0, level = 0;
+    QuaZipFile srcFile(&srcZip);
+    if (!srcFile.open(QFile::ReadOnly, &method, &level, true))
+        return false;
+
+    QuaZipFile dstFile(&qzip);
+    if (!dstFile.open(QFile::WriteOnly, QuaZipNewInfo(qfileInfo), nullptr, qfileInfo.crc, method,
+                      level, true)) {
+        srcFile.close();
+        return false;
+    }
+
+    const int bufferLength = 65535;
+    char buffer[bufferLength];
+    while (1) {
+        const qint64 nrBytes = srcFile.read(buffer, bufferLength);
+        if (nrBytes <= 0)
+            break;
+        dstFile.write(buffer, nrBytes);
+    }
+
+    dstFile.close();
+    srcFile.close();
+
+    return dstFile.getZipError() == ZIP_OK && srcFile.getZipError() == UNZ_OK;
+}
+
+void determineCompression(const QString &filePath, DocumentFileSystem::SaveMode mode,
+                          int *method, int *level)
+{
+    // Deflating media and office documents, which are already compressed, burns
+    // CPU time for no gain in size. Such files are simply stored.
+    static const QSet<QString> compressedSuffixes = []() {
+        const QStringList suffixes =
+                QStringLiteral("jpg,jpeg,png,gif,webp,heic,mp4,mov,avi,wmv,m4v,mpg,mpeg,mp3,m4a,"
+                               "ogg,flac,pdf,zip,gz,7z,docx,xlsx,pptx,odt,odp,ods,scrite")
+                        .split(QChar(','), Qt::SkipEmptyParts);
+        return QSet<QString>(suffixes.begin(), suffixes.end());
+    }();
+
+    const QFileInfo fi(filePath);
+    if (compressedSuffixes.contains(fi.suffix().toLower())) {
+        *method = 0; // Stored
+        *level = 0;
+        return;
+    }
+
+    *method = Z_DEFLATED;
+
+    // The header is the only file that changes on every save. During auto-save
+    // (which is non-blocking) we want that to be quick, while an explicit save
+    // can afford to compress it fully.
+    const QString fileName = fi.fileName();
+    if (fileName == DocumentFileSystemData::normalHeaderFile
+        || fileName == DocumentFileSystemData::encryptedHeaderFile)
+        *level = mode == DocumentFileSystem::NonBlockingSaveMode ? Z_BEST_SPEED
+                                                                  : Z_BEST_COMPRESSION;
+    else
+        *level = Z_DEFAULT_COMPRESSION;
+}
+
+void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip, QuaZip *srcZip,
+                      const DocumentFileSystemArchive &archive, const QSet<QString> &dirtyPaths,
+                      DocumentFileSystem::SaveMode mode,
+                      QHash<QString, DocumentFileSystemFileStamp> &entries)
 {
-    const QFileInfoList entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs,
-                                                    QDir::Name | QDir::DirsLast);
-    for (const QFileInfo &entry : entries) {
+    const QFileInfoList entryInfos = dir.entryInfoList(
+            QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs, QDir::Name | QDir::DirsLast);
+    for (const QFileInfo &entry : entryInfos) {
         if (entry.isDir()) {
-            doZipRecursively(entry.absoluteFilePath(), rootDir, qzip);
+            doZipRecursively(entry.absoluteFilePath(), rootDir, qzip, srcZip, archive, dirtyPaths,
+                             mode, entries);
             continue;
         }
 
         const QString srcFilePath = entry.absoluteFilePath();
         const QString dstFilePath = rootDir.relativeFilePath(srcFilePath);
+        const DocumentFileSystemFileStamp stamp = DocumentFileSystemFileStamp::of(entry);
+
+        // Files that have not changed since the last load or save can be copied
+        // over in their compressed form, from the previously saved archive.
+        if (srcZip != nullptr && !dirtyPaths.contains(dstFilePath)
+            && archive.entries.value(dstFilePath) == stamp && stamp.isValid()
+            && doCopyRawEntry(*srcZip, dstFilePath, qzip)) {
+            entries.insert(dstFilePath, stamp);
+            continue;
+        }
 
         QFile srcFile(srcFilePath);
         if (!srcFile.open(QFile::ReadOnly)) {
@@ -287,8 +572,12 @@ void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip)
             continue;
         }
 
+        int method = Z_DEFLATED, level = Z_DEFAULT_COMPRESSION;
+        determineCompression(dstFilePath, mode, &method, &level);
+
         QuaZipFile dstFile(&qzip);
-        if (!dstFile.open(QFile::WriteOnly, QuaZipNewInfo(dstFilePath, srcFilePath))) {
+        if (!dstFile.open(QFile::WriteOnly, QuaZipNewInfo(dstFilePath, srcFilePath), nullptr, 0,
+                          method, level)) {
             qInfo("Could not open '%s' for writing.", qPrintable(srcFilePath));
             continue;
         }
@@ -304,30 +593,66 @@ void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip)
 
         dstFile.close();
         srcFile.close();
+
+        entries.insert(dstFilePath, stamp);
     }
 }
 
-bool doZip(const QFileInfo &fileInfo, const QDir &rootDir)
+bool doZip(const QFileInfo &fileInfo, const QDir &rootDir, DocumentFileSystemArchive *archive,
+           const QSet<QString> &dirtyPaths, DocumentFileSystem::SaveMode mode)
 {
     const QString zipFileName = fileInfo.absoluteFilePath();
 
-    QuaZip qzip(zipFileName);
+    // The new archive is written next to the target and renamed over it upon commit,
+    // so the previous file stays intact until the new one is complete.
+    QSaveFile zipFile(zipFileName);
+    if (!zipFile.open(QFile::WriteOnly)) {
+        qInfo("Could not create %s", qPrintable(zipFileName));
+        return false;
+    }
+
+    QuaZip qzip(&zipFile);
     qzip.setUtf8Enabled(true);
+    qzip.setAutoClose(false);
     if (!qzip.open(QuaZip::mdCreate)) {
         qInfo("Could not create %s", qPrintable(zipFileName));
+        zipFile.cancelWriting();
         return false;
     }
 
-    doZipRecursively(rootDir, rootDir, qzip);
+    QuaZip srcZip(archive->fileName);
+    srcZip.setUtf8Enabled(true);
+    const bool canCopyEntries = archive->isValid() && srcZip.open(QuaZip::mdUnzip);
+
+    QHash<QString, DocumentFileSystemFileStamp> entries;
+    doZipRecursively(rootDir, rootDir, qzip, canCopyEntries ? &srcZip : nullptr, *archive,
+                     dirtyPaths, mode, entries);
 
     qzip.close();
+    if (canCopyEntries)
+        srcZip.close();
+
+    if (qzip.getZipError() != ZIP_OK) {
+        zipFile.cancelWriting();
+        return false;
+    }
+
+    if (!zipFile.commit())
+        return false;
+
+    archive->fileName = zipFileName;
+    archive->stamp = DocumentFileSystemFileStamp::of(QFileInfo(zipFileName));
+    archive->entries = entries;
 
     return true;
 }
 
 bool saveTask(const QByteArray &header, bool encrypt, const QDir &folder,
-              const QString &targetFileName, QMutex *mutex)
+              const QString &targetFileName, QMutex *mutex, DocumentFileSystemArchive *archive,
+              const QSet<QString> &dirtyPaths, DocumentFileSystem::SaveMode mode)
 {
+    PROFILE_THIS_FUNCTION;
+
     QMutexLocker mutexLocker(mutex);
 
     QByteArray headerData = header;
@@ -347,26 +672,21 @@ bool saveTask(const QByteArray &header, bool encrypt, const QDir &folder,
     if (!headerFile.commit())
         return false;
 
-    const QString tmpFileName = QStandardPaths::writableLocation(QStandardPaths::TempLocation)
-            + QStringLiteral("/scrite_") + QString::number(QDateTime::currentMSecsSinceEpoch())
-            + QStringLiteral("_temp.scrite");
-
-    const QFileInfo fileInfo(tmpFileName);
-    bool success = doZip(fileInfo, folder);
+    // Header is always written afresh.
+    QSet<QString> dirtyPaths2 = dirtyPaths;
+    dirtyPaths2 += folder.relativeFilePath(headerFileName);
 
-    if (success && QFile::exists(tmpFileName) && QFileInfo(tmpFileName).size() > 0) {
-        if (QFile::exists(targetFileName))
-            success &= QFile::remove(targetFileName);
-        if (success)
-            success &= QFile::copy(tmpFileName, targetFileName);
-        QFile::remove(tmpFileName);
-    }
+    const bool success = doZip(QFileInfo(targetFileName), folder, archive, dirtyPaths2, mode);
+    if (!success)
+        archive->reset();
 
     return success;
 }
 
 bool DocumentFileSystem::save(const QString &fileName, bool encrypt, SaveMode mode)
 {
+    PROFILE_THIS_FUNCTION;
+
     if (fileName.isEmpty())
         return false;
 
@@ -423,14 +743,25 @@ bool DocumentFileSystem::save(const QString &fileName, bool encrypt, SaveMode mo
         watcher->setObjectName(saveTaskWatcher);
         connect(watcher, &QFutureWatcher<bool>::finished, this,
                 &DocumentFileSystem::saveTaskFinished);
-        watcher->setFuture(QtConcurrent::run(saveTask, d->header, encrypt, QDir(d->folder->path()),
-                                             fileName, &d->folderMutex));
+        const QByteArray header = d->header;
+        const QDir folder(d->folder->path());
+        QMutex *mutex = &d->folderMutex;
+        DocumentFileSystemArchive *archive = &d->archive;
+        const QSet<QString> dirtyPaths = d->dirtyPaths;
+        d->dirtyPaths.clear();
+
+        watcher->setFuture(QtConcurrent::run([=]() {
+            return saveTask(header, encrypt, folder, fileName, mutex, archive, dirtyPaths, mode);
+        }));
 
         return true;
     }
 
-    const bool ret =
-            saveTask(d->header, encrypt, QDir(d->folder->path()), fileName, &d->folderMutex);
+    const QSet<QString> dirtyPaths = d->dirtyPaths;
+    d->dirtyPaths.clear();
+
+    const bool ret = saveTask(d->header, encrypt, QDir(d->folder->path()), fileName,
+                              &d->folderMutex, &d->archive, dirtyPaths, mode);
     return ret;
 #endif
 }
@@ -445,6 +776,41 @@ QByteArray DocumentFileSystem::header() const
     return d->header;
 }
 
+DocumentFileSystem::HeaderEncoding DocumentFileSystem::headerEncoding(const QByteArray &header)
+{
+    // CBOR self-describe tag (55799), which can never begin a JSON document.
+    static const QByteArray binaryMarker = QByteArrayLiteral("\xD9\xD9\xF7");
+    return header.startsWith(binaryMarker) ? BinaryHeaderEncoding : JsonHeaderEncoding;
+}
+
+QByteArray DocumentFileSystem::encodeHeader(const QJsonObject &json, HeaderEncoding encoding)
+{
+    if (encoding == BinaryHeaderEncoding) {
+        const QCborValue cbor(QCborKnownTags::Signature, QCborMap::fromJsonObject(json));
+        return cbor.toCbor();
+    }
+
+    return QJsonDocument(json).toJson();
+}
+
+QJsonObject DocumentFileSystem::decodeHeader(const QByteArray &header)
+{
+    if (header.isEmpty())
+        return QJsonObject();
+
+    if (headerEncoding(header) == BinaryHeaderEncoding) {
+        QCborParserError error;
+        const QCborValue cbor = QCborValue::fromCbor(header, &error);
+        if (error.error != QCborError::NoError)
+            return QJsonObject();
+
+        const QCborValue map = cbor.isTag() ? cbor.taggedValue() : cbor;
+        return map.toMap().toJsonObject();
+    }
+
+    return QJsonDocument::fromJson(header).object();
+}
+
 QFile *DocumentFileSystem::open(const QString &path, QFile::OpenMode mode)
 {
     if (path.isEmpty())
@@ -460,6 +826,9 @@ QFile *DocumentFileSystem::open(const QString &path, QFile::OpenMode mode)
         return nullptr;
     }
 
+    if (mode & QFile::WriteOnly)
+        d->markDirty(completePath);
+
     return file;
 }
 
@@ -495,6 +864,7 @@ bool DocumentFileSystem::write(const QString &path, const QByteArray &bytes)
         return false;
 
     file.write(bytes);
+    d->markDirty(completePath);
     return true;
 }
 
@@ -514,6 +884,7 @@ QString DocumentFileSystem::add(const QString &fileName, const QString &ns)
     const QString path = ns + "/" + QString::number(d->fileNameCounter++) + "." + suffix;
     const QString absPath = this->absolutePath(path, true);
     if (QFile::copy(fileName, absPath)) {
+        d->markDirty(absPath);
         QFile copiedFile(absPath);
         copiedFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner
                                   | QFileDevice::ReadUser | QFileDevice::WriteUser
@@ -541,6 +912,7 @@ QString DocumentFileSystem::duplicate(const QString &fileName, const QString &ns
     const QString path = ns + "/" + QString::number(d->fileNameCounter++) + "." + fi.suffix();
     const QString absPath = this->absolutePath(path, true);
     if (QFile::copy(fi.absoluteFilePath(), absPath)) {
+        d->markDirty(absPath);
         QFile copiedFile(absPath);
         copiedFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner
                                   | QFileDevice::ReadUser | QFileDevice::WriteUser
@@ -655,6 +1027,8 @@ QString DocumentFileSystem::addFile(const QString &srcFile, const QString &dstPa
     if (!QFile::copy(srcFile, dstPath))
         return QString();
 
+    d->markDirty(absDstPath);
+
     // That's it
     return this->relativePath(absDstPath);
 }
@@ -709,6 +1083,7 @@ QString DocumentFileSystem::addImage(const QImage &srcImage, const QString &dstP
 
     const QString suffix = QFileInfo(absDstPath).suffix().toUpper();
     const bool ret = imageToSave.save(absDstPath, qPrintable(suffix));
+    d->markDirty(absDstPath);
     return ret ? this->relativePath(absDstPath) : QString();
 }
 
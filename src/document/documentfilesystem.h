@@ -20,6 +20,7 @@
 #include <QSize>
 #include <QImage>
 #include <QFileInfo>
+#include <QJsonObject>
 
 class DocumentFile;
 
@@ -39,12 +40,26 @@ public:
     enum Format { UnknownFormat, ScriteFormat, ZipFormat };
     bool load(const QString &fileName, Format *format = nullptr);
 
+    // Read just the header (or one file) from a document on disk, without
+    // extracting the rest of the archive into a temporary folder.
+    static QByteArray peekHeader(const QString &fileName, Format *format = nullptr);
+    static QByteArray peekFile(const QString &fileName, const QString &path);
+
     enum SaveMode { BlockingSaveMode, NonBlockingSaveMode };
     bool save(const QString &fileName, bool encrypt = false, SaveMode mode = BlockingSaveMode);
 
     void setHeader(const QByteArray &header);
     QByteArray header() const;
 
+    // Header can be encoded as indented JSON text (readable by all versions) or
+    // as compact CBOR, which is marked by the CBOR self-describe tag at the start.
+    // Decoding detects the encoding from that marker, and falls back to JSON.
+    enum HeaderEncoding { JsonHeaderEncoding, BinaryHeaderEncoding };
+    static HeaderEncoding headerEncoding(const QByteArray &header);
+    static QByteArray encodeHeader(const QJsonObject &json,
+                                   HeaderEncoding encoding = JsonHeaderEncoding);
+    static QJsonObject decodeHeader(const QByteArray &header);
+
     QFile *open(const QString &path, QFile::OpenMode mode = QFile::ReadOnly);
 
     QByteArray read(const QString &path);
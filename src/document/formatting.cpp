@@ -15,6 +15,7 @@
 #include "appwindow.h"
 #include "formatting.h"
 #include "application.h"
+#include "timeprofiler.h"
 #include "scritedocument.h"
 #include "qobjectserializer.h"
 #include "qobjectserializer.h"
@@ -551,15 +552,19 @@ void ScreenplayPageLayout::configure(QTextDocument *document) const
     const QSizeF pageSize = stdResolution ? m_paperRect.size()
                                           : m_pageLayout.pageSize().sizePixels(qt_defaultDpi());
 
+    // Each of these relayout the whole document, even if nothing changes. So we only
+    // set them when they are different.
     document->setUseDesignMetrics(true);
-    document->setPageSize(pageSize);
+    if (document->pageSize() != pageSize)
+        document->setPageSize(pageSize);
 
     QTextFrameFormat format;
     format.setTopMargin(pixelMargins.top());
     format.setBottomMargin(pixelMargins.bottom());
     format.setLeftMargin(pixelMargins.left());
     format.setRightMargin(pixelMargins.right());
-    document->rootFrame()->setFrameFormat(format);
+    if (document->rootFrame()->frameFormat() != format)
+        document->rootFrame()->setFrameFormat(format);
 }
 
 void ScreenplayPageLayout::configure(QPagedPaintDevice *printer) const
@@ -1324,6 +1329,7 @@ private:
     QPointer<SceneElement> m_sceneElement;
     QPointer<SceneDocumentBinder> m_binder;
     QString m_highlightedText;
+    TransliterationEngine::ScriptRunCache m_scriptRunCache;
     int m_formatMTime = -1;
     int m_spellCheckMTime = -1;
     QMetaObject::Connection m_spellCheckConnection;
@@ -1645,7 +1651,21 @@ public:
 
     QString word() const { return this->selectedText(); }
     bool isMisspelled() const { return m_misspelledFragment.isValid(); }
-    QStringList suggestions() const { return m_misspelledFragment.suggestions(); }
+    QString misspelledWord() const
+    {
+        if (!m_misspelledFragment.isValid())
+            return QString();
+
+        return this->block().text().mid(m_misspelledFragment.start(),
+                                        m_misspelledFragment.length());
+    }
+    QStringList suggestions() const
+    {
+        if (!m_misspelledFragment.isValid())
+            return QStringList();
+
+        return SpellCheckService::suggestions(this->misspelledWord());
+    }
 
     void replace(const QString &word)
     {
@@ -1934,13 +1954,13 @@ void SceneDocumentBinder::setCursorPosition(int val)
 #endif
 
     this->setWordUnderCursorIsMisspelled(false);
-    this->setSpellingSuggestions(QStringList());
 
     SpellCheckCursor cursor(this->document(), val);
 
     QTextBlock block = cursor.block();
     if (!block.isValid()) {
         qDebug("[%d] There is no block at the cursor position %d.", __LINE__, val);
+        this->lookupSpellingSuggestions(QString());
         emit cursorPositionChanged();
         m_textFormat->reset();
         return;
@@ -1954,13 +1974,14 @@ void SceneDocumentBinder::setCursorPosition(int val)
 
     if (userData == nullptr) {
         this->setCurrentElement(nullptr);
+        this->lookupSpellingSuggestions(QString());
         m_textFormat->reset();
         qWarning("[%d] TextDocument has a block at %d that isnt backed by a SceneElement!!",
                  __LINE__, val);
     } else {
         this->setCurrentElement(userData->sceneElement());
         this->setWordUnderCursorIsMisspelled(cursor.isMisspelled());
-        this->setSpellingSuggestions(cursor.suggestions());
+        this->lookupSpellingSuggestions(cursor.misspelledWord());
 
         if (m_selectionStartPosition >= 0 && m_selectionEndPosition > 0
             && m_selectionStartPosition != m_selectionEndPosition) {
@@ -2322,7 +2343,7 @@ void SceneDocumentBinder::replaceWordAt(int position, const QString &with)
         return;
 
     cursor.replace(with);
-    this->setSpellingSuggestions(QStringList());
+    this->lookupSpellingSuggestions(QString());
     this->setWordUnderCursorIsMisspelled(false);
 }
 
@@ -2337,7 +2358,7 @@ void SceneDocumentBinder::addWordAtPositionToDictionary(int position)
 
     if (SpellCheckService::addToDictionary(cursor.word())) {
         cursor.resetCharFormat();
-        this->setSpellingSuggestions(QStringList());
+        this->lookupSpellingSuggestions(QString());
         this->setWordUnderCursorIsMisspelled(false);
     }
 }
@@ -2353,7 +2374,7 @@ void SceneDocumentBinder::addWordAtPositionToIgnoreList(int position)
 
     ScriteDocument::instance()->addToSpellCheckIgnoreList(cursor.word());
     cursor.resetCharFormat();
-    this->setSpellingSuggestions(QStringList());
+    this->lookupSpellingSuggestions(QString());
     this->setWordUnderCursorIsMisspelled(false);
 }
 
@@ -2770,6 +2791,8 @@ void SceneDocumentBinder::componentComplete()
 
 void SceneDocumentBinder::highlightBlock(const QString &text)
 {
+    PROFILE_THIS_FUNCTION;
+
     if (m_initializingDocument || m_sceneElementTaskIsRunning)
         return;
 
@@ -2806,16 +2829,17 @@ void SceneDocumentBinder::highlightBlock(const QString &text)
 
     // Per-language fonts.
     if (m_applyLanguageFonts) {
-        const QList<TransliterationEngine::Boundary> boundaries =
-                TransliterationEngine::instance()->evaluateBoundaries(text);
+        const TransliterationEngine *engine = TransliterationEngine::instance();
+        const QVector<TransliterationEngine::ScriptRun> &runs =
+                userData->m_scriptRunCache.scriptRuns(text);
 
-        for (const TransliterationEngine::Boundary &boundary : boundaries) {
-            if (boundary.isEmpty() || boundary.language == TransliterationEngine::English)
+        for (const TransliterationEngine::ScriptRun &run : runs) {
+            if (run.language == TransliterationEngine::English)
                 continue;
 
             QTextCharFormat format;
-            format.setFontFamily(boundary.font.family());
-            this->mergeFormat(boundary.start, boundary.end - boundary.start + 1, format);
+            format.setFontFamily(engine->languageFontFamily(run.language));
+            this->mergeFormat(run.start, run.length, format);
         }
 
         if (m_currentElement == element)
@@ -3089,6 +3113,8 @@ void SceneDocumentBinder::setCurrentElement(SceneElement *val)
                    &SceneDocumentBinder::resetCurrentElement);
         disconnect(m_currentElement, &SceneElement::typeChanged, this,
                    &SceneDocumentBinder::nextTabFormatChanged);
+        if (m_spellCheckEnabled)
+            m_currentElement->spellCheck()->setPriority(SpellCheckService::BackgroundPriority);
     }
 
     m_currentElement = val;
@@ -3098,6 +3124,10 @@ void SceneDocumentBinder::setCurrentElement(SceneElement *val)
                 &SceneDocumentBinder::resetCurrentElement);
         connect(m_currentElement, &SceneElement::typeChanged, this,
                 &SceneDocumentBinder::nextTabFormatChanged);
+
+        // The paragraph being edited is spell-checked ahead of all others.
+        if (m_spellCheckEnabled)
+            m_currentElement->spellCheck()->setPriority(SpellCheckService::ForegroundPriority);
     }
 
     emit currentElementChanged();
@@ -3636,6 +3666,13 @@ void SceneDocumentBinder::setSpellingSuggestions(const QStringList &val)
     emit spellingSuggestionsChanged();
 }
 
+void SceneDocumentBinder::lookupSpellingSuggestions(const QString &word)
+{
+    m_spellingSuggestionsLookup.lookup(word, this, [=](const QStringList &suggestions) {
+        this->setSpellingSuggestions(suggestions);
+    });
+}
+
 void SceneDocumentBinder::setWordUnderCursorIsMisspelled(bool val)
 {
     if (m_wordUnderCursorIsMisspelled == val)
@@ -800,6 +800,7 @@ private:
     void setCompletionPrefix(const QString &prefix, int start = -1, int end = -1);
     void setCompletionMode(CompletionMode val);
     void setSpellingSuggestions(const QStringList &val);
+    void lookupSpellingSuggestions(const QString &word);
     void setWordUnderCursorIsMisspelled(bool val);
 
     void onSceneAboutToReset();
@@ -854,6 +855,7 @@ private:
     ExecLaterTimer m_rehighlightTimer;
     QStringList m_autoCompleteHints;
     QStringList m_priorityAutoCompleteHints;
+    SpellingSuggestionsLookup m_spellingSuggestionsLookup;
     QStringList m_spellingSuggestions;
     int m_currentElementCursorPosition = -1;
     bool m_wordUnderCursorIsMisspelled = false;
@@ -55,6 +55,166 @@ static QDataStream &operator>>(QDataStream &ds, QTextLayout::FormatRange &format
     return ds;
 }
 
+/**
+ * Instead of storing full snapshots of the scene before and after each edit, scene
+ * undo commands store a delta: heading/synopsis fields before and after, the list of
+ * paragraph IDs (only if paragraphs were added, removed or reordered) and old/new
+ * content of only those paragraphs that actually changed.
+ *
+ * Snapshots taken while capturing the delta are cheap, because QString and QVector
+ * are implicitly shared. They are discarded as soon as the delta is computed.
+ */
+struct SceneUndoParagraph
+{
+    bool exists = false;
+    int type = SceneElement::Action;
+    QString text;
+    QVector<QTextLayout::FormatRange> formats;
+
+    bool operator==(const SceneUndoParagraph &other) const
+    {
+        return this->exists == other.exists && this->type == other.type
+                && this->text == other.text && this->formats == other.formats;
+    }
+    bool operator!=(const SceneUndoParagraph &other) const { return !(*this == other); }
+
+    static SceneUndoParagraph capture(const SceneElement *element)
+    {
+        SceneUndoParagraph ret;
+        ret.exists = true;
+        ret.type = element->type();
+        ret.text = element->text();
+        ret.formats = element->textFormats();
+        return ret;
+    }
+};
+
+struct SceneUndoFields
+{
+    QString synopsis;
+    QColor color;
+    int cursorPosition = -1;
+    QString locationType;
+    QString location;
+    QString moment;
+};
+
+struct SceneUndoSnapshot
+{
+    SceneUndoFields fields;
+    QStringList paragraphIds;
+    QVector<SceneUndoParagraph> paragraphs;
+
+    static SceneUndoSnapshot capture(const Scene *scene)
+    {
+        SceneUndoSnapshot ret;
+        ret.fields.synopsis = scene->synopsis();
+        ret.fields.color = scene->color();
+        ret.fields.cursorPosition = scene->cursorPosition();
+        ret.fields.locationType = scene->heading()->locationType();
+        ret.fields.location = scene->heading()->location();
+        ret.fields.moment = scene->heading()->moment();
+
+        const int nrElements = scene->elementCount();
+        ret.paragraphIds.reserve(nrElements);
+        ret.paragraphs.reserve(nrElements);
+        for (int i = 0; i < nrElements; i++) {
+            const SceneElement *element = scene->elementAt(i);
+            ret.paragraphIds.append(element->id());
+            ret.paragraphs.append(SceneUndoParagraph::capture(element));
+        }
+
+        return ret;
+    }
+};
+
+struct SceneUndoDelta
+{
+    SceneUndoFields before;
+    SceneUndoFields after;
+
+    // Paragraph IDs are recorded only if paragraphs were added, removed or reordered.
+    bool paragraphsChanged = false;
+    QStringList beforeParagraphIds;
+    QStringList afterParagraphIds;
+
+    // Paragraph ID -> (before, after), only for paragraphs that changed.
+    QHash<QString, QPair<SceneUndoParagraph, SceneUndoParagraph>> paragraphs;
+
+    static SceneUndoDelta evaluate(const SceneUndoSnapshot &before,
+                                   const SceneUndoSnapshot &after)
+    {
+        SceneUndoDelta ret;
+        ret.before = before.fields;
+        ret.after = after.fields;
+
+        if (before.paragraphIds != after.paragraphIds) {
+            ret.paragraphsChanged = true;
+            ret.beforeParagraphIds = before.paragraphIds;
+            ret.afterParagraphIds = after.paragraphIds;
+        }
+
+        QHash<QString, int> afterIndexes;
+        afterIndexes.reserve(after.paragraphIds.size());
+        for (int i = 0; i < after.paragraphIds.size(); i++)
+            afterIndexes.insert(after.paragraphIds.at(i), i);
+
+        for (int i = 0; i < before.paragraphIds.size(); i++) {
+            const QString &id = before.paragraphIds.at(i);
+            const SceneUndoParagraph &beforePara = before.paragraphs.at(i);
+
+            SceneUndoParagraph afterPara;
+            const auto afterIt = afterIndexes.find(id);
+            if (afterIt != afterIndexes.end()) {
+                afterPara = after.paragraphs.at(afterIt.value());
+                afterIndexes.erase(afterIt);
+            }
+
+            if (beforePara != afterPara)
+                ret.paragraphs.insert(id, qMakePair(beforePara, afterPara));
+        }
+
+        // Whatever is left over in afterIndexes are newly added paragraphs
+        for (auto it = afterIndexes.constBegin(); it != afterIndexes.constEnd(); ++it)
+            ret.paragraphs.insert(it.key(),
+                                  qMakePair(SceneUndoParagraph(), after.paragraphs.at(it.value())));
+
+        return ret;
+    }
+
+    // Folds a delta that was captured right after this one into this.
+    void merge(const SceneUndoDelta &next)
+    {
+        this->after = next.after;
+
+        if (next.paragraphsChanged) {
+            if (!this->paragraphsChanged)
+                this->beforeParagraphIds = next.beforeParagraphIds;
+            this->afterParagraphIds = next.afterParagraphIds;
+            this->paragraphsChanged = true;
+        }
+
+        for (auto it = next.paragraphs.constBegin(); it != next.paragraphs.constEnd(); ++it) {
+            auto existing = this->paragraphs.find(it.key());
+            if (existing == this->paragraphs.end())
+                this->paragraphs.insert(it.key(), it.value());
+            else
+                existing.value().second = it.value().second;
+        }
+    }
+
+    bool isEmpty() const
+    {
+        return this->paragraphs.isEmpty() && !this->paragraphsChanged
+                && this->before.synopsis == this->after.synopsis
+                && this->before.color == this->after.color
+                && this->before.cursorPosition == this->after.cursorPosition
+                && this->before.locationType == this->after.locationType
+                && this->before.location == this->after.location
+                && this->before.moment == this->after.moment;
+    }
+};
+
 class PushSceneUndoCommand;
 class SceneUndoCommand : public QUndoCommand
 {
@@ -72,15 +232,15 @@ public:
     bool mergeWith(const QUndoCommand *other);
 
 private:
-    QByteArray toByteArray(Scene *scene) const;
-    Scene *fromByteArray(const QByteArray &bytes) const;
+    Scene *findScene() const;
+    bool apply(Scene *scene, bool useAfterState) const;
 
 private:
     friend class PushSceneUndoCommand;
     Scene *m_scene = nullptr;
     QString m_sceneId;
-    QByteArray m_after;
-    QByteArray m_before;
+    SceneUndoSnapshot m_beforeSnapshot;
+    SceneUndoDelta m_delta;
     bool m_allowMerging = true;
     char m_padding[7];
     QDateTime m_timestamp;
@@ -93,7 +253,7 @@ SceneUndoCommand::SceneUndoCommand(Scene *scene, bool allowMerging)
 {
     m_padding[0] = 0; // just to get rid of the unused private variable warning.
     m_sceneId = m_scene->id();
-    m_before = this->toByteArray(scene);
+    m_beforeSnapshot = SceneUndoSnapshot::capture(scene);
 }
 
 SceneUndoCommand::~SceneUndoCommand() { }
@@ -101,26 +261,33 @@ SceneUndoCommand::~SceneUndoCommand() { }
 void SceneUndoCommand::undo()
 {
     SceneUndoCommand::current = this;
-    Scene *scene = this->fromByteArray(m_before);
+    Scene *scene = this->findScene();
+    const bool success = scene != nullptr && this->apply(scene, false);
     SceneUndoCommand::current = nullptr;
 
-    if (scene == nullptr)
+    if (!success)
         this->setObsolete(true);
 }
 
 void SceneUndoCommand::redo()
 {
     if (m_scene != nullptr) {
-        m_after = this->toByteArray(m_scene);
+        m_delta = SceneUndoDelta::evaluate(m_beforeSnapshot, SceneUndoSnapshot::capture(m_scene));
+        m_beforeSnapshot = SceneUndoSnapshot();
         m_scene = nullptr;
+
+        // Nothing changed, so there is nothing to undo either.
+        if (m_delta.isEmpty())
+            this->setObsolete(true);
         return;
     }
 
     SceneUndoCommand::current = this;
-    Scene *scene = this->fromByteArray(m_after);
+    Scene *scene = this->findScene();
+    const bool success = scene != nullptr && this->apply(scene, true);
     SceneUndoCommand::current = nullptr;
 
-    if (scene == nullptr)
+    if (!success)
         this->setObsolete(true);
 }
 
@@ -137,7 +304,7 @@ bool SceneUndoCommand::mergeWith(const QUndoCommand *other)
         const qint64 timegap = qAbs(m_timestamp.msecsTo(cmd->m_timestamp));
         static qint64 minTimegap = 1000;
         if (timegap < minTimegap) {
-            m_after = cmd->m_after;
+            m_delta.merge(cmd->m_delta);
             m_timestamp = cmd->m_timestamp;
             return true;
         }
@@ -146,14 +313,102 @@ bool SceneUndoCommand::mergeWith(const QUndoCommand *other)
     return false;
 }
 
-QByteArray SceneUndoCommand::toByteArray(Scene *scene) const
+Scene *SceneUndoCommand::findScene() const
 {
-    return scene->toByteArray();
+    const Structure *structure = ScriteDocument::instance()->structure();
+    const StructureElement *element = structure->findElementBySceneID(m_sceneId);
+    return element == nullptr ? nullptr : element->scene();
 }
 
-Scene *SceneUndoCommand::fromByteArray(const QByteArray &bytes) const
+bool SceneUndoCommand::apply(Scene *scene, bool useAfterState) const
 {
-    return Scene::fromByteArray(bytes);
+    if (scene->id() != m_sceneId)
+        return false;
+
+    QScopedValueRollback<bool> ure(scene->m_undoRedoEnabled, false);
+
+    emit scene->sceneAboutToReset();
+
+    const SceneUndoFields &fields = useAfterState ? m_delta.after : m_delta.before;
+    scene->setSynopsis(fields.synopsis);
+    scene->setColor(fields.color);
+    scene->setCursorPosition(fields.cursorPosition);
+    scene->heading()->setLocationType(fields.locationType);
+    scene->heading()->setLocation(fields.location);
+    scene->heading()->setMoment(fields.moment);
+
+    auto paragraphFor = [=](const QString &id, bool *changed) {
+        const auto it = m_delta.paragraphs.constFind(id);
+        *changed = it != m_delta.paragraphs.constEnd();
+        return *changed ? (useAfterState ? it.value().second : it.value().first)
+                        : SceneUndoParagraph();
+    };
+
+    auto updateElement = [](SceneElement *element, const SceneUndoParagraph &para) {
+        element->setType(SceneElement::Type(para.type));
+        element->setText(para.text);
+        element->setTextFormats(para.formats);
+    };
+
+    const QStringList &paragraphIds =
+            useAfterState ? m_delta.afterParagraphIds : m_delta.beforeParagraphIds;
+    if (!m_delta.paragraphsChanged) {
+        // Only the contents of some paragraphs changed.
+        for (int i = 0; i < scene->elementCount(); i++) {
+            SceneElement *element = scene->elementAt(i);
+            bool changed = false;
+            const SceneUndoParagraph para = paragraphFor(element->id(), &changed);
+            if (changed && para.exists)
+                updateElement(element, para);
+        }
+    } else {
+        // Remove stale paragraphs
+        const QSet<QString> paragraphIdSet(paragraphIds.begin(), paragraphIds.end());
+        for (int i = scene->elementCount() - 1; i >= 0; i--) {
+            SceneElement *element = scene->elementAt(i);
+            if (!paragraphIdSet.contains(element->id()))
+                scene->removeElement(element);
+        }
+
+        // Insert new paragraphs, move reordered ones in place and update changed ones.
+        for (int i = 0; i < paragraphIds.size(); i++) {
+            const QString &id = paragraphIds.at(i);
+            bool changed = false;
+            const SceneUndoParagraph para = paragraphFor(id, &changed);
+
+            SceneElement *element = i < scene->elementCount() ? scene->elementAt(i) : nullptr;
+            if (element && element->id() == id) {
+                if (changed && para.exists)
+                    updateElement(element, para);
+                continue;
+            }
+
+            // The paragraph is either new, or further down and has to be moved up to here.
+            SceneElement *movedElement = nullptr;
+            for (int j = i + 1; j < scene->elementCount() && movedElement == nullptr; j++) {
+                if (scene->elementAt(j)->id() == id)
+                    movedElement = scene->elementAt(j);
+            }
+
+            SceneUndoParagraph newPara = para;
+            if (movedElement != nullptr) {
+                if (!changed || !para.exists)
+                    newPara = SceneUndoParagraph::capture(movedElement);
+                scene->removeElement(movedElement);
+            } else if (!changed || !para.exists) {
+                continue;
+            }
+
+            element = new SceneElement(scene);
+            element->setId(id);
+            updateElement(element, newPara);
+            scene->insertElementAt(element, i);
+        }
+    }
+
+    emit scene->sceneReset(fields.cursorPosition);
+
+    return true;
 }
 
 class PushSceneUndoCommand
@@ -194,7 +449,7 @@ PushSceneUndoCommand::~PushSceneUndoCommand()
 ///////////////////////////////////////////////////////////////////////////////
 
 SceneHeading::SceneHeading(QObject *parent)
-    : QObject(parent), m_scene(qobject_cast<Scene *>(parent))
+    : QObject(parent), Invalidatable(ElementStage), m_scene(qobject_cast<Scene *>(parent))
 {
     m_padding[0] = 0; // just to get rid of the unused private variable warning.
     connect(this, &SceneHeading::momentChanged, this, &SceneHeading::textChanged);
@@ -205,8 +460,6 @@ SceneHeading::SceneHeading(QObject *parent)
         this->markAsModified();
         this->evaluateWordCountLater();
     });
-    connect(this, &SceneHeading::wordCountChanged, m_scene, &Scene::evaluateWordCountLater,
-            Qt::UniqueConnection);
 }
 
 SceneHeading::~SceneHeading() { }
@@ -319,13 +572,10 @@ void SceneHeading::parseFrom(const QString &text)
     this->setMoment(_moment);
 }
 
-void SceneHeading::timerEvent(QTimerEvent *event)
+void SceneHeading::flushInvalidation(int key)
 {
-    if (event->timerId() == m_wordCountTimer.timerId()) {
-        m_wordCountTimer.stop();
+    if (key == WordCountInvalidation)
         this->evaluateWordCount();
-    } else
-        QObject::timerEvent(event);
 }
 
 void SceneHeading::renameCharacter(const QString &from, const QString &to)
@@ -364,6 +614,9 @@ void SceneHeading::setWordCount(int val)
 
     m_wordCount = val;
     emit wordCountChanged();
+
+    if (m_scene != nullptr)
+        m_scene->reportWordCountChange(this);
 }
 
 void SceneHeading::evaluateWordCount()
@@ -374,21 +627,17 @@ void SceneHeading::evaluateWordCount()
 
 void SceneHeading::evaluateWordCountLater()
 {
-    m_wordCountTimer.start(100, this);
+    this->invalidateLater(WordCountInvalidation, 100);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 SceneElement::SceneElement(QObject *parent)
-    : QObject(parent), m_scene(qobject_cast<Scene *>(parent))
+    : QObject(parent), Invalidatable(ElementStage), m_scene(qobject_cast<Scene *>(parent))
 {
     connect(this, &SceneElement::typeChanged, this, &SceneElement::elementChanged);
     connect(this, &SceneElement::textChanged, this, &SceneElement::elementChanged);
     connect(this, &SceneElement::elementChanged, [=]() { this->markAsModified(); });
-
-    if (m_scene != nullptr)
-        connect(this, &SceneElement::wordCountChanged, m_scene, &Scene::evaluateWordCountLater,
-                Qt::UniqueConnection);
 }
 
 SceneElement::~SceneElement()
@@ -469,6 +718,7 @@ void SceneElement::setText(const QString &val)
 
     PushSceneUndoCommand cmd(m_scene);
 
+    const QString oldText = m_text;
     m_text = val.trimmed();
     if (m_spellCheck != nullptr)
         m_spellCheck->setText(m_text);
@@ -476,7 +726,7 @@ void SceneElement::setText(const QString &val)
     emit textChanged(val);
 
     this->reportSceneElementChanged(Scene::ElementTextChange);
-    this->evaluateWordCountLater();
+    this->evaluateWordCountDelta(oldText, m_text);
 }
 
 void SceneElement::setAlignment(Qt::Alignment val)
@@ -739,7 +989,12 @@ QList<int> SceneElement::autoCapitalizePositions(const QString &text)
 
 QJsonArray SceneElement::find(const QString &text, int flags) const
 {
-    return SearchEngine::indexesOf(text, m_text, flags);
+    return SearchEngine::toJson(this->findMatches(text, flags));
+}
+
+TextMatches SceneElement::findMatches(const QString &text, int flags) const
+{
+    return SearchEngine::matchesOf(text, m_text, flags);
 }
 
 void SceneElement::serializeToJson(QJsonObject &json) const
@@ -884,23 +1139,15 @@ QVector<QTextLayout::FormatRange> SceneElement::textFormatsFromJson(const QJsonA
 
 bool SceneElement::event(QEvent *event)
 {
-    if (event->type() == QEvent::ParentChange) {
-        if (m_scene != nullptr)
-            disconnect(this, &SceneElement::wordCountChanged, m_scene,
-                       &Scene::evaluateWordCountLater);
+    if (event->type() == QEvent::ParentChange)
         m_scene = qobject_cast<Scene *>(this->parent());
-        if (m_scene != nullptr)
-            connect(this, &SceneElement::wordCountChanged, m_scene, &Scene::evaluateWordCountLater,
-                    Qt::UniqueConnection);
-    }
 
     return QObject::event(event);
 }
 
-void SceneElement::timerEvent(QTimerEvent *event)
+void SceneElement::flushInvalidation(int key)
 {
-    if (event->timerId() == m_changeTimer.timerId()) {
-        m_changeTimer.stop();
+    if (key == ChangeInvalidation) {
         if (m_scene != nullptr) {
             if (m_changeCounters.take(Scene::ElementTypeChange) > 0)
                 emit m_scene->sceneElementChanged(this, Scene::ElementTypeChange);
@@ -908,11 +1155,8 @@ void SceneElement::timerEvent(QTimerEvent *event)
                 emit m_scene->sceneElementChanged(this, Scene::ElementTextChange);
         }
         m_changeCounters.clear();
-    } else if (event->timerId() == m_wordCountTimer.timerId()) {
-        m_wordCountTimer.stop();
+    } else if (key == WordCountInvalidation)
         this->evaluateWordCount();
-    } else
-        QObject::timerEvent(event);
 }
 
 void SceneElement::renameCharacter(const QString &from, const QString &to)
@@ -948,7 +1192,7 @@ void SceneElement::reportSceneElementChanged(int type)
 {
     if (m_scene != nullptr) {
         m_changeCounters[type]++;
-        m_changeTimer.start(0, this);
+        this->invalidateLater(ChangeInvalidation);
     }
 }
 
@@ -959,6 +1203,9 @@ void SceneElement::setWordCount(int val)
 
     m_wordCount = val;
     emit wordCountChanged();
+
+    if (m_scene != nullptr)
+        m_scene->reportWordCountChange(this);
 }
 
 void SceneElement::evaluateWordCount()
@@ -968,7 +1215,45 @@ void SceneElement::evaluateWordCount()
 
 void SceneElement::evaluateWordCountLater()
 {
-    m_wordCountTimer.start(100, this);
+    this->invalidateLater(WordCountInvalidation, 100);
+}
+
+void SceneElement::evaluateWordCountDelta(const QString &oldText, const QString &newText)
+{
+    // Without an up-to-date count for oldText, there is nothing to apply a delta
+    // to. The pending evaluation will count all words anyway.
+    if (this->isInvalidationPending(WordCountInvalidation))
+        return;
+
+    // Only words overlapping the edited range are counted again. The range is
+    // widened up to whitespace on either side, because words never span across
+    // whitespace.
+    const int minLength = qMin(oldText.length(), newText.length());
+
+    int prefix = 0;
+    while (prefix < minLength && oldText.at(prefix) == newText.at(prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < minLength - prefix
+           && oldText.at(oldText.length() - 1 - suffix)
+                   == newText.at(newText.length() - 1 - suffix))
+        ++suffix;
+
+    int start = prefix;
+    while (start > 0 && !oldText.at(start - 1).isSpace())
+        --start;
+
+    int oldEnd = oldText.length() - suffix;
+    int newEnd = newText.length() - suffix;
+    while (oldEnd < oldText.length() && !oldText.at(oldEnd).isSpace()) {
+        ++oldEnd;
+        ++newEnd;
+    }
+
+    const int oldWords = TransliterationEngine::wordCount(oldText.mid(start, oldEnd - start));
+    const int newWords = TransliterationEngine::wordCount(newText.mid(start, newEnd - start));
+    this->setWordCount(m_wordCount - oldWords + newWords);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1075,7 +1360,7 @@ void DistinctElementValuesMap::include(const DistinctElementValuesMap &other)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Scene::Scene(QObject *parent) : QAbstractListModel(parent)
+Scene::Scene(QObject *parent) : QAbstractListModel(parent), Invalidatable(SceneStage)
 {
     m_padding[0] = 0; // just to get rid of the unused private variable warning.
     this->setStructureElement(qobject_cast<StructureElement *>(parent));
@@ -1090,6 +1375,8 @@ Scene::Scene(QObject *parent) : QAbstractListModel(parent)
     connect(this, &Scene::indexCardFieldValuesChanged, this, &Scene::sceneChanged);
     connect(m_heading, &SceneHeading::textChanged, this, &Scene::sceneChanged);
     connect(m_heading, &SceneHeading::enabledChanged, this, &Scene::sceneChanged);
+    connect(m_heading, &SceneHeading::enabledChanged, this,
+            [=]() { this->reportWordCountChange(m_heading); });
     connect(this, &Scene::sceneChanged, [=]() { this->markAsModified(); });
 
     connect(this, &Scene::sceneElementChanged, this, &Scene::onSceneElementChanged);
@@ -1671,6 +1958,8 @@ void Scene::insertElementAt(SceneElement *ptr, int index)
     ptr->setParent(this);
 
     m_elements.insert(index, ptr);
+    ptr->m_reportedWordCount = ptr->wordCount();
+    this->setWordCount(m_wordCount + ptr->m_reportedWordCount);
     connect(ptr, &SceneElement::elementChanged, this, &Scene::sceneChanged);
     connect(ptr, &SceneElement::aboutToDelete, this, &Scene::removeElement);
     connect(this, &Scene::cursorPositionChanged, ptr, &SceneElement::cursorPositionChanged);
@@ -1702,6 +1991,9 @@ void Scene::removeElement(SceneElement *ptr)
 
     emit aboutToRemoveSceneElement(ptr);
     m_elements.removeAt(row);
+    if (ptr->m_reportedWordCount > 0)
+        this->setWordCount(m_wordCount - ptr->m_reportedWordCount);
+    ptr->m_reportedWordCount = -1;
 
     disconnect(ptr, &SceneElement::elementChanged, this, &Scene::sceneChanged);
     disconnect(ptr, &SceneElement::aboutToDelete, this, &Scene::removeElement);
@@ -1739,6 +2031,8 @@ void Scene::setElements(const QList<SceneElement *> &list)
     this->endResetModel();
 
     emit elementCountChanged();
+
+    this->evaluateWordCount();
 }
 
 int Scene::elementCount() const
@@ -2415,13 +2709,10 @@ bool Scene::event(QEvent *event)
     return QObject::event(event);
 }
 
-void Scene::timerEvent(QTimerEvent *event)
+void Scene::flushInvalidation(int key)
 {
-    if (event->timerId() == m_wordCountTimer.timerId()) {
-        m_wordCountTimer.stop();
+    if (key == WordCountInvalidation)
         this->evaluateWordCount();
-    } else
-        QObject::timerEvent(event);
 }
 
 void Scene::setStructureElement(StructureElement *ptr)
@@ -2474,6 +2765,9 @@ void Scene::setElementsList(const QList<SceneElement *> &list)
         emit aboutToRemoveSceneElement(ptr);
         if (ptr->type() == SceneElement::Character)
             m_characterElementMap.remove(ptr);
+        if (ptr->m_reportedWordCount > 0)
+            this->setWordCount(m_wordCount - ptr->m_reportedWordCount);
+        ptr->m_reportedWordCount = -1;
         GarbageCollector::instance()->add(ptr);
     }
 
@@ -2584,18 +2878,50 @@ void Scene::evaluateWordCount()
 {
     int wordCount = 0;
 
-    if (m_heading->isEnabled())
-        wordCount += m_heading->wordCount();
+    m_heading->m_reportedWordCount = m_heading->isEnabled() ? m_heading->wordCount() : 0;
+    wordCount += m_heading->m_reportedWordCount;
 
-    for (const SceneElement *element : qAsConst(m_elements))
-        wordCount += element->wordCount();
+    for (SceneElement *element : qAsConst(m_elements)) {
+        element->m_reportedWordCount = element->wordCount();
+        wordCount += element->m_reportedWordCount;
+    }
 
     this->setWordCount(wordCount);
 }
 
 void Scene::evaluateWordCountLater()
 {
-    m_wordCountTimer.start(100, this);
+    this->invalidateLater(WordCountInvalidation, 100);
+}
+
+/**
+ * Scene and Screenplay word counts are kept up to date by delta. Each child remembers, in its
+ * m_reportedWordCount, the count it last contributed, and reportWordCountChange() applies only
+ * the difference to the total. evaluateWordCount() recomputes the total from scratch and resets
+ * those baselines.
+ */
+void Scene::reportWordCountChange(SceneHeading *heading)
+{
+    if (heading != m_heading)
+        return;
+
+    const int count = heading->isEnabled() ? heading->wordCount() : 0;
+    const int delta = count - heading->m_reportedWordCount;
+    heading->m_reportedWordCount = count;
+    if (delta != 0)
+        this->setWordCount(m_wordCount + delta);
+}
+
+void Scene::reportWordCountChange(SceneElement *element)
+{
+    // Elements that are not (yet) part of m_elements are not counted.
+    if (element->m_reportedWordCount < 0)
+        return;
+
+    const int delta = element->wordCount() - element->m_reportedWordCount;
+    element->m_reportedWordCount = element->wordCount();
+    if (delta != 0)
+        this->setWordCount(m_wordCount + delta);
 }
 
 void Scene::trimIndexCardFieldValues()
@@ -35,6 +35,7 @@
 #include "execlatertimer.h"
 #include "qobjectproperty.h"
 #include "qobjectserializer.h"
+#include "invalidationscheduler.h"
 #include "spellcheckservice.h"
 #include "genericarraymodel.h"
 #include "qobjectlistmodel.h"
@@ -45,8 +46,9 @@ class SceneElement;
 class StructureElement;
 class SceneDocumentBinder;
 class PushSceneUndoCommand;
+struct TextMatch;
 
-class SceneHeading : public QObject, public Modifiable
+class SceneHeading : public QObject, public Modifiable, public Invalidatable
 {
     Q_OBJECT
     QML_ELEMENT
@@ -98,13 +100,15 @@ public:
     Q_SIGNAL void wordCountChanged();
 
 protected:
-    void timerEvent(QTimerEvent *event);
+    // Invalidatable interface
+    void flushInvalidation(int key);
 
 private:
     friend class Scene;
     void renameCharacter(const QString &from, const QString &to);
 
     enum Mode { DisplayMode, EditMode };
+    enum Invalidation { WordCountInvalidation };
     QString toString(Mode mode) const;
     void setWordCount(int val);
     void evaluateWordCount();
@@ -118,10 +122,13 @@ private:
     QString m_location = "Somewhere";
     QString m_locationType = "EXT";
     int m_wordCount = 0;
-    QBasicTimer m_wordCountTimer;
+    int m_reportedWordCount = 0; // contribution to Scene::wordCount()
 };
 
-class SceneElement : public QObject, public Modifiable, public QObjectSerializer::Interface
+class SceneElement : public QObject,
+                     public Modifiable,
+                     public QObjectSerializer::Interface,
+                     public Invalidatable
 {
     Q_OBJECT
     Q_INTERFACES(QObjectSerializer::Interface)
@@ -200,6 +207,7 @@ public:
     Q_SIGNAL void elementChanged();
 
     Q_INVOKABLE QJsonArray find(const QString &text, int flags) const;
+    QVector<TextMatch> findMatches(const QString &text, int flags) const;
 
     void serializeToJson(QJsonObject &) const;
     void deserializeFromJson(const QJsonObject &obj);
@@ -213,15 +221,19 @@ public:
 
 protected:
     bool event(QEvent *event);
-    void timerEvent(QTimerEvent *event);
+
+    // Invalidatable interface
+    void flushInvalidation(int key);
 
 private:
     friend class Scene;
+    enum Invalidation { ChangeInvalidation, WordCountInvalidation };
     void renameCharacter(const QString &from, const QString &to);
     void reportSceneElementChanged(int type);
     void setWordCount(int val);
     void evaluateWordCount();
     void evaluateWordCountLater();
+    void evaluateWordCountDelta(const QString &oldText, const QString &newText);
 
 private:
     mutable QString m_id;
@@ -231,9 +243,8 @@ private:
     QVector<QTextLayout::FormatRange> m_textFormats;
     Scene *m_scene = nullptr;
     int m_wordCount = 0;
+    int m_reportedWordCount = -1; // contribution to Scene::wordCount(), -1 if not counted
     mutable SpellCheckService *m_spellCheck = nullptr;
-    QBasicTimer m_changeTimer;
-    QBasicTimer m_wordCountTimer;
     QMap<int, int> m_changeCounters;
 };
 
@@ -257,6 +268,15 @@ public:
 
     void include(const DistinctElementValuesMap &other);
 
+    // Calls func(value, nrElements) once for each distinct value, without
+    // making copies of the underlying maps.
+    template <class Func>
+    void forEachValue(Func func) const
+    {
+        for (auto it = m_reverseMap.constBegin(); it != m_reverseMap.constEnd(); ++it)
+            func(it.key(), it.value().size());
+    }
+
 private:
     SceneElement::Type m_type = SceneElement::Character;
     QMap<SceneElement *, QString> m_forwardMap;
@@ -305,7 +325,10 @@ public:
     QList<SceneElement *> shotElements(const QString &name) const { return this->elements(name); }
 };
 
-class Scene : public QAbstractListModel, public QObjectSerializer::Interface, public Modifiable
+class Scene : public QAbstractListModel,
+              public QObjectSerializer::Interface,
+              public Modifiable,
+              public Invalidatable
 {
     Q_OBJECT
     Q_INTERFACES(QObjectSerializer::Interface)
@@ -551,9 +574,12 @@ public:
 
 protected:
     bool event(QEvent *event);
-    void timerEvent(QTimerEvent *event);
+
+    // Invalidatable interface
+    void flushInvalidation(int key);
 
 private:
+    enum Invalidation { WordCountInvalidation };
     void setStructureElement(StructureElement *ptr);
     QList<SceneElement *> elementsList() const { return m_elements; }
     void setElementsList(const QList<SceneElement *> &list);
@@ -565,6 +591,8 @@ private:
     void setWordCount(int val);
     void evaluateWordCount();
     void evaluateWordCountLater();
+    void reportWordCountChange(SceneHeading *heading);
+    void reportWordCountChange(SceneElement *element);
     void trimIndexCardFieldValues();
 
     void evaluateSummary();
@@ -575,7 +603,9 @@ private:
     friend class StructureElement;
     friend class SceneElement;
     friend class SceneHeading;
+    friend class SceneUndoCommand;
     friend class SceneDocumentBinder;
+    friend class ScenePresenceMatrix;
 
     QString m_act;
     Type m_type = Standard;
@@ -587,7 +617,6 @@ private:
     int m_actIndex = -1;
     int m_episodeIndex = -1;
     int m_wordCount = 0;
-    QBasicTimer m_wordCountTimer;
     QString m_episode;
     StructureElement *m_structureElement = nullptr;
     QString m_summary;
@@ -17,8 +17,11 @@
 #include "hourglass.h"
 #include "screenplay.h"
 #include "application.h"
+#include "searchengine.h"
 #include "scritedocument.h"
 #include "garbagecollector.h"
+#include "screenplaysearchindex.h"
+#include "invalidationscheduler.h"
 
 #include <QMimeData>
 #include <QSettings>
@@ -56,6 +59,8 @@ ScreenplayElement::ScreenplayElement(QObject *parent)
     connect(this, &ScreenplayElement::sceneChanged, this, &ScreenplayElement::wordCountChanged);
     connect(this, &ScreenplayElement::screenplayChanged, this,
             &ScreenplayElement::wordCountChanged);
+    connect(this, &ScreenplayElement::wordCountChanged, this,
+            &ScreenplayElement::reportWordCountChange);
 }
 
 ScreenplayElement::~ScreenplayElement()
@@ -138,11 +143,6 @@ void ScreenplayElement::setScreenplay(Screenplay *val)
         return;
 
     m_screenplay = val;
-
-    if (m_screenplay != nullptr)
-        connect(this, &ScreenplayElement::wordCountChanged, m_screenplay,
-                &Screenplay::evaluateWordCountLater, Qt::UniqueConnection);
-
     emit screenplayChanged();
 }
 
@@ -225,6 +225,8 @@ void ScreenplayElement::setScene(Scene *val)
     connect(m_scene, &Scene::typeChanged, this, &ScreenplayElement::sceneTypeChanged);
     connect(m_scene, &Scene::groupsChanged, this, &ScreenplayElement::onSceneGroupsChanged);
     connect(m_scene, &Scene::wordCountChanged, this, &ScreenplayElement::wordCountChanged);
+    connect(m_scene, &Scene::elementCountChanged, this,
+            &ScreenplayElement::reportParagraphCountChange);
 
     if (m_screenplay)
         connect(m_scene->heading(), &SceneHeading::enabledChanged, this,
@@ -387,16 +389,29 @@ void ScreenplayElement::resetScene()
 void ScreenplayElement::resetScreenplay()
 {
     if (m_screenplay != nullptr) {
-        disconnect(this, &ScreenplayElement::wordCountChanged, m_screenplay,
-                   &Screenplay::evaluateWordCountLater);
         m_screenplay->evaluateWordCountLater();
+        m_screenplay->evaluateParagraphCountsLater();
     }
+    m_reportedWordCount = -1;
+    m_reportedParagraphCount = -1;
     m_screenplay = nullptr;
     emit screenplayChanged();
 
     this->deleteLater();
 }
 
+void ScreenplayElement::reportWordCountChange()
+{
+    if (m_screenplay != nullptr)
+        m_screenplay->reportWordCountChange(this);
+}
+
+void ScreenplayElement::reportParagraphCountChange()
+{
+    if (m_screenplay != nullptr)
+        m_screenplay->reportParagraphCountChange(this);
+}
+
 void ScreenplayElement::setActIndex(int val)
 {
     if (m_actIndex == val)
@@ -428,9 +443,9 @@ void ScreenplayElement::setElementIndex(int val)
 
 Screenplay::Screenplay(QObject *parent)
     : QAbstractListModel(parent),
+      Invalidatable(ScreenplayStage),
       m_scriteDocument(qobject_cast<ScriteDocument *>(parent)),
-      m_activeScene(this, "activeScene"),
-      m_sceneNumberEvaluationTimer("Screenplay.m_sceneNumberEvaluationTimer")
+      m_activeScene(this, "activeScene")
 {
     connect(this, &Screenplay::titleChanged, this, &Screenplay::emptyChanged);
     connect(this, &Screenplay::emailChanged, this, &Screenplay::emptyChanged);
@@ -446,7 +461,6 @@ Screenplay::Screenplay(QObject *parent)
     connect(this, &Screenplay::phoneNumberChanged, this, &Screenplay::emptyChanged);
     connect(this, &Screenplay::emptyChanged, this, &Screenplay::screenplayChanged);
     connect(this, &Screenplay::coverPagePhotoChanged, this, &Screenplay::screenplayChanged);
-    connect(this, &Screenplay::elementsChanged, this, &Screenplay::evaluateSceneNumbersLater);
     connect(this, &Screenplay::elementsChanged, this, &Screenplay::evaluateParagraphCountsLater);
     connect(this, &Screenplay::elementsChanged, this,
             &Screenplay::evaluateIfHeightHintsAreAvailableLater);
@@ -817,7 +831,7 @@ static int screenplayIndexOfElement(Screenplay *screenplay, ScreenplayElement *p
 
 void Screenplay::insertElementAt(ScreenplayElement *ptr, int index)
 {
-    if (ptr == nullptr || m_elements.indexOf(ptr) >= 0)
+    if (ptr == nullptr || this->indexOfElement(ptr) >= 0)
         return;
 
     index = (index < 0 || index >= m_elements.size()) ? m_elements.size() : index;
@@ -843,6 +857,7 @@ void Screenplay::insertElementAt(ScreenplayElement *ptr, int index)
     // Screenplay::setPropertyFromObjectList()
     ptr->setParent(this);
     this->connectToScreenplayElementSignals(ptr);
+    this->updateElementPositions(index);
 
     this->endInsertRows();
 
@@ -870,10 +885,13 @@ void Screenplay::insertElementsAt(const QList<ScreenplayElement *> &elements, in
         ptr->setParent(this);
         this->connectToScreenplayElementSignals(ptr);
         m_elements.insert(insertIndex, ptr);
+        ptr->m_position = insertIndex;
         emit elementInserted(ptr, insertIndex);
         ++insertIndex;
     }
 
+    this->updateElementPositions(startIndex);
+
     this->endInsertRows();
     emit elementCountChanged();
     emit elementsChanged();
@@ -886,7 +904,7 @@ void Screenplay::removeElement(ScreenplayElement *ptr)
     if (ptr == nullptr)
         return;
 
-    const int row = m_elements.indexOf(ptr);
+    const int row = this->indexOfElement(ptr);
     if (row < 0)
         return;
 
@@ -903,6 +921,7 @@ void Screenplay::removeElement(ScreenplayElement *ptr)
 
     this->beginRemoveRows(QModelIndex(), row, row);
     m_elements.removeAt(row);
+    ptr->m_position = -1;
 
     Scene *scene = ptr->scene();
     if (scene != nullptr) {
@@ -910,12 +929,12 @@ void Screenplay::removeElement(ScreenplayElement *ptr)
         scene->setActIndex(-1);
         scene->setEpisode(QString());
         scene->setEpisodeIndex(-1);
-        scene->setScreenplayElementIndexList(QList<int>());
 
         // If this scene still exists as another element in the screenplay, then
         // it is going to get the above properties set in evaluateSceneNumbers() shortly.
     }
 
+    this->updateElementPositions(row, QList<Scene *>() << scene);
     this->disconnectFromScreenplayElementSignals(ptr);
 
     this->endRemoveRows();
@@ -934,7 +953,7 @@ void Screenplay::removeElements(const QList<ScreenplayElement *> &givenElements)
 {
     QList<ScreenplayElement *> elements;
     std::copy_if(givenElements.begin(), givenElements.end(), std::back_inserter(elements),
-                 [=](ScreenplayElement *element) { return m_elements.contains(element); });
+                 [=](ScreenplayElement *element) { return this->indexOfElement(element) >= 0; });
     if (elements.isEmpty())
         return;
 
@@ -959,10 +978,10 @@ void Screenplay::removeElements(const QList<ScreenplayElement *> &givenElements)
     int leastIndex = INT_MAX;
 
     std::sort(elements.begin(), elements.end(), [=](ScreenplayElement *e1, ScreenplayElement *e2) {
-        return m_elements.indexOf(e1) < m_elements.indexOf(e2);
+        return this->indexOfElement(e1) < this->indexOfElement(e2);
     });
     for (ScreenplayElement *element : qAsConst(elements)) {
-        const int elementIndex = m_elements.indexOf(element);
+        const int elementIndex = this->indexOfElement(element);
         leastIndex = qMin(elementIndex, leastIndex);
         Batch &lastBatch = batches.last();
         if (!lastBatch.isValid()) {
@@ -981,12 +1000,14 @@ void Screenplay::removeElements(const QList<ScreenplayElement *> &givenElements)
         }
     }
 
+    QList<Scene *> detachedScenes;
     for (const Batch &batch : qAsConst(batches)) {
         if (!batch.isValid())
             continue;
         this->beginRemoveRows(QModelIndex(), batch.startIndex, batch.endIndex);
         for (int row = batch.endIndex; row >= batch.startIndex; row--) {
             ScreenplayElement *ptr = m_elements.takeAt(row);
+            ptr->m_position = -1;
 
             Scene *scene = ptr->scene();
             if (scene != nullptr) {
@@ -994,7 +1015,7 @@ void Screenplay::removeElements(const QList<ScreenplayElement *> &givenElements)
                 scene->setActIndex(-1);
                 scene->setEpisode(QString());
                 scene->setEpisodeIndex(-1);
-                scene->setScreenplayElementIndexList(QList<int>());
+                detachedScenes.append(scene);
             }
 
             this->disconnectFromScreenplayElementSignals(ptr);
@@ -1007,6 +1028,9 @@ void Screenplay::removeElements(const QList<ScreenplayElement *> &givenElements)
         leastIndex = batch.startIndex;
     }
 
+    // Batches are processed in reverse order, so leastIndex is the first removed row.
+    this->updateElementPositions(leastIndex, detachedScenes);
+
     emit elementCountChanged();
     emit elementsChanged();
     this->validateCurrentElementIndex();
@@ -1219,6 +1243,7 @@ void Screenplay::moveSelectedElements(int toRow)
 
     QList<ScreenplayElement *> selectedElements;
     QHash<ScreenplayElement *, QPair<int, int>> movement;
+    int firstChangedRow = m_elements.size();
     for (int i = m_elements.size() - 1; i >= 0; i--) {
         ScreenplayElement *element = m_elements.at(i);
         if (!element->isSelected())
@@ -1232,6 +1257,7 @@ void Screenplay::moveSelectedElements(int toRow)
         selectedElements.prepend(element);
         movement[element] = qMakePair(i, 0);
         m_elements.removeAt(i);
+        firstChangedRow = i;
     }
 
     if (cmd == nullptr)
@@ -1247,6 +1273,8 @@ void Screenplay::moveSelectedElements(int toRow)
         movement[element].second = toRow + selectedElements.size();
     }
 
+    this->updateElementPositions(qMin(firstChangedRow, toRow));
+
     this->endResetModel();
 
     emit elementsChanged();
@@ -1586,6 +1614,7 @@ void Screenplay::clearElements()
         // this->removeElement(m_elements.first());
 
         ScreenplayElement *ptr = m_elements.takeLast();
+        ptr->m_position = -1;
         emit elementRemoved(ptr, m_elements.size());
         disconnect(ptr, nullptr, this, nullptr);
 
@@ -1601,6 +1630,8 @@ void Screenplay::clearElements()
         GarbageCollector::instance()->add(ptr);
     }
 
+    this->updateElementPositions(0);
+
     this->endResetModel();
 
     emit elementCountChanged();
@@ -1954,6 +1985,15 @@ int Screenplay::firstIndexOfScene(Scene *scene) const
 
 int Screenplay::indexOfElement(ScreenplayElement *element) const
 {
+    if (element == nullptr)
+        return -1;
+
+    const int index = element->m_position;
+    if (index >= 0 && index < m_elements.size() && m_elements.at(index) == element)
+        return index;
+
+    // The element could be part of more than one screenplay, in which case its
+    // cached position belongs to one of the others.
     return m_elements.indexOf(element);
 }
 
@@ -2088,10 +2128,14 @@ bool Screenplay::setElements(const QList<ScreenplayElement *> &list)
     if (!copy.isEmpty())
         return false;
 
-    copy = m_elements;
+    int firstChangedRow = 0;
+    while (firstChangedRow < list.size()
+           && list.at(firstChangedRow) == m_elements.at(firstChangedRow))
+        ++firstChangedRow;
 
     this->beginResetModel();
     m_elements = list;
+    this->updateElementPositions(firstChangedRow);
     this->endResetModel();
 
     emit elementsChanged();
@@ -2278,12 +2322,14 @@ void Screenplay::evaluateWordCount()
 {
     int wordCount = 0;
 
-    for (const ScreenplayElement *element : qAsConst(m_elements)) {
+    for (ScreenplayElement *element : qAsConst(m_elements)) {
+        element->m_reportedWordCount = 0;
         if (element->elementType() == ScreenplayElement::SceneElementType) {
             const Scene *scene = element->scene();
             if (scene)
-                wordCount += scene->wordCount();
+                element->m_reportedWordCount = scene->wordCount();
         }
+        wordCount += element->m_reportedWordCount;
     }
 
     this->setWordCount(wordCount);
@@ -2291,7 +2337,55 @@ void Screenplay::evaluateWordCount()
 
 void Screenplay::evaluateWordCountLater()
 {
-    m_wordCountTimer.start(100, this);
+    this->invalidateLater(WordCountInvalidation, 100);
+}
+
+void Screenplay::reportWordCountChange(ScreenplayElement *element)
+{
+    // Elements added since the last evaluateWordCount() are not counted yet,
+    // they will be picked up when the pending evaluation runs.
+    if (element->m_reportedWordCount < 0)
+        return;
+
+    int count = 0;
+    if (element->elementType() == ScreenplayElement::SceneElementType) {
+        const Scene *scene = element->scene();
+        if (scene)
+            count = scene->wordCount();
+    }
+
+    const int delta = count - element->m_reportedWordCount;
+    element->m_reportedWordCount = count;
+    if (delta != 0)
+        this->setWordCount(m_wordCount + delta);
+}
+
+bool Screenplay::findSearchCandidates(const QString &text, int flags,
+                                      QHash<Scene *, QSet<SceneElement *>> &candidates) const
+{
+    // Sometimes Screenplay is used by ScreenplayAdapter to house a single
+    // scene. It is cheaper to scan that one scene than to index it.
+    if (m_scriteDocument == nullptr)
+        return false;
+
+    // The index knows only about literal text, not about patterns.
+    if (flags & SearchEngine::SearchRegularExpression)
+        return false;
+
+    // Paragraphs report text changes to their scenes with a delay; get them
+    // into the index before it is consulted.
+    InvalidationScheduler::flushCurrentThread();
+
+    if (m_searchIndex == nullptr)
+        m_searchIndex = new ScreenplaySearchIndex(const_cast<Screenplay *>(this));
+
+    for (ScreenplayElement *element : qAsConst(m_elements)) {
+        Scene *scene = element->scene();
+        if (scene != nullptr && !m_searchIndex->containsScene(scene))
+            m_searchIndex->addScene(scene);
+    }
+
+    return m_searchIndex->findCandidates(text, candidates);
 }
 
 bool Screenplay::getPasteDataFromClipboard(QJsonObject &clipboardJson) const
@@ -2363,7 +2457,7 @@ void Screenplay::evaluateIfHeightHintsAreAvailable()
 
 void Screenplay::evaluateIfHeightHintsAreAvailableLater()
 {
-    m_evalHeightHintsAvailableTimer.start(100, this);
+    this->invalidateLater(HeightHintsAvailableInvalidation, 100);
 }
 
 void Screenplay::setCurrentElementIndex(int val)
@@ -2456,6 +2550,17 @@ QJsonArray Screenplay::search(const QString &text, int flags) const
     HourGlass hourGlass;
 
     QJsonArray ret;
+    if (text.isEmpty())
+        return ret;
+
+    QHash<Scene *, QSet<SceneElement *>> candidates;
+    const bool hasCandidates = this->findSearchCandidates(text, flags, candidates);
+
+    const QString _sceneIndex = QStringLiteral("sceneIndex");
+    const QString _elementIndex = QStringLiteral("elementIndex");
+    const QString _sceneResultIndex = QStringLiteral("sceneResultIndex");
+    const QString _from = QStringLiteral("from");
+    const QString _to = QStringLiteral("to");
 
     const int nrScenes = m_elements.size();
     for (int i = 0; i < nrScenes; i++) {
@@ -2463,28 +2568,28 @@ QJsonArray Screenplay::search(const QString &text, int flags) const
         if (scene == nullptr)
             continue;
 
+        const QSet<SceneElement *> sceneCandidates = candidates.value(scene);
+        if (hasCandidates && sceneCandidates.isEmpty())
+            continue;
+
         int sceneResultIndex = 0;
 
         const int nrElements = scene->elementCount();
         for (int j = 0; j < nrElements; j++) {
             SceneElement *element = scene->elementAt(j);
+            if (hasCandidates && !sceneCandidates.contains(element))
+                continue;
 
-            const QJsonArray results = element->find(text, flags);
-            if (!results.isEmpty()) {
-                for (int r = 0; r < results.size(); r++) {
-                    const QJsonObject result = results.at(r).toObject();
-
-                    QJsonObject item;
-                    item.insert(QStringLiteral("sceneIndex"), i);
-                    item.insert(QStringLiteral("elementIndex"), j);
-                    item.insert(QStringLiteral("sceneResultIndex"), sceneResultIndex++);
-
-                    const QString _from = QStringLiteral("from");
-                    const QString _to = QStringLiteral("to");
-                    item.insert(_from, _from);
-                    item.insert(_to, _to);
-                    ret.append(item);
-                }
+            // JSON objects are created only for the QML side, which needs them.
+            const TextMatches matches = element->findMatches(text, flags);
+            for (const TextMatch &match : matches) {
+                QJsonObject item;
+                item.insert(_sceneIndex, i);
+                item.insert(_elementIndex, j);
+                item.insert(_sceneResultIndex, sceneResultIndex++);
+                item.insert(_from, match.from);
+                item.insert(_to, match.to);
+                ret.append(item);
             }
         }
     }
@@ -2497,11 +2602,25 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
     HourGlass hourGlass;
 
     int counter = 0;
+    if (text.isEmpty())
+        return counter;
+
+    QHash<Scene *, QSet<SceneElement *>> candidates;
+    const bool hasCandidates = this->findSearchCandidates(text, flags, candidates);
+
+    // A scene that occurs more than once in the screenplay is replaced in only once.
+    QSet<Scene *> replacedScenes;
 
     const int nrScenes = m_elements.size();
     for (int i = 0; i < nrScenes; i++) {
         Scene *scene = m_elements.at(i)->scene();
-        if (scene == nullptr)
+        if (scene == nullptr || replacedScenes.contains(scene))
+            continue;
+
+        replacedScenes.insert(scene);
+
+        const QSet<SceneElement *> sceneCandidates = candidates.value(scene);
+        if (hasCandidates && sceneCandidates.isEmpty())
             continue;
 
         bool begunUndoCapture = false;
@@ -2509,10 +2628,13 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
         const int nrElements = scene->elementCount();
         for (int j = 0; j < nrElements; j++) {
             SceneElement *element = scene->elementAt(j);
-            const QJsonArray results = element->find(text, flags);
-            counter += results.size();
+            if (hasCandidates && !sceneCandidates.contains(element))
+                continue;
 
-            if (results.isEmpty())
+            const TextMatches matches = element->findMatches(text, flags);
+            counter += matches.size();
+
+            if (matches.isEmpty())
                 continue;
 
             if (!begunUndoCapture) {
@@ -2521,13 +2643,9 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
             }
 
             QString elementText = element->text();
-            for (int r = results.size() - 1; r >= 0; r--) {
-                const QString _from = QStringLiteral("from");
-                const QString _to = QStringLiteral("to");
-                const QJsonObject result = results.at(r).toObject();
-                const int from = result.value(_from).toInt();
-                const int to = result.value(_to).toInt();
-                elementText = elementText.replace(from, to - from + 1, replacementText);
+            for (int r = matches.size() - 1; r >= 0; r--) {
+                const TextMatch &match = matches.at(r);
+                elementText.replace(match.from, match.length(), replacementText);
             }
 
             element->setText(elementText);
@@ -2888,6 +3006,8 @@ void Screenplay::setPropertyFromObjectList(const QString &propName, const QList<
             emit elementInserted(ptr, m_elements.size() - 1);
         }
 
+        this->updateElementPositions(0);
+
         this->endResetModel();
 
         emit elementCountChanged();
@@ -3062,26 +3182,27 @@ bool Screenplay::event(QEvent *event)
     return QObject::event(event);
 }
 
-void Screenplay::timerEvent(QTimerEvent *te)
+void Screenplay::flushInvalidation(int key)
 {
-    if (te->timerId() == m_sceneNumberEvaluationTimer.timerId()) {
-        m_sceneNumberEvaluationTimer.stop();
-        this->evaluateSceneNumbers();
-    } else if (te->timerId() == m_updateBreakTitlesTimer.timerId()) {
-        m_updateBreakTitlesTimer.stop();
+    switch (key) {
+    case SceneNumbersInvalidation:
+        this->evaluateSceneNumbersFrom(m_sceneNumbersDirtyFrom);
+        break;
+    case BreakTitlesInvalidation:
         this->updateBreakTitles();
-    } else if (te->timerId() == m_paragraphCountEvaluationTimer.timerId()) {
-        m_paragraphCountEvaluationTimer.stop();
+        break;
+    case ParagraphCountsInvalidation:
         this->evaluateParagraphCounts();
-    } else if (te->timerId() == m_wordCountTimer.timerId()) {
-        m_wordCountTimer.stop();
+        break;
+    case WordCountInvalidation:
         this->evaluateWordCount();
-    } else if (te->timerId() == m_evalHeightHintsAvailableTimer.timerId()) {
-        m_evalHeightHintsAvailableTimer.stop();
+        break;
+    case HeightHintsAvailableInvalidation:
         this->evaluateIfHeightHintsAreAvailable();
-    } else if (te->timerId() == m_selectedElementsOmitStatusChangedTimer.timerId()) {
-        m_selectedElementsOmitStatusChangedTimer.stop();
+        break;
+    case SelectedElementsOmitStatusInvalidation:
         emit selectedElementsOmitStatusChanged();
+        break;
     }
 }
 
@@ -3120,122 +3241,159 @@ void Screenplay::onScreenplayElementOmittedChanged()
     else
         emit elementIncluded(element, sceneIndex);
 
-    m_selectedElementsOmitStatusChangedTimer.start(10, this);
+    this->invalidateLater(SelectedElementsOmitStatusInvalidation, 10);
 }
 
 void Screenplay::updateBreakTitlesLater()
 {
-    m_updateBreakTitlesTimer.start(0, this);
+    this->invalidateLater(BreakTitlesInvalidation);
 }
 
 void Screenplay::evaluateSceneNumbers(bool minorAlso)
 {
+    this->evaluateSceneNumbersFrom(0, minorAlso);
+}
+
+void Screenplay::evaluateSceneNumbersLater()
+{
+    m_sceneNumbersDirtyFrom = 0;
+    this->invalidateLater(SceneNumbersInvalidation);
+}
+
+void Screenplay::evaluateSceneNumbersFrom(int fromIndex, bool minorAlso)
+{
+    m_sceneNumbersDirtyFrom = INT_MAX;
+
     // Sometimes Screenplay is used by ScreenplayAdapter to house a single
     // scene. In such cases, we must not evaluate numbers.
     if (m_scriteDocument == nullptr)
         return;
 
-    int actIndex = -1, totalActIndex = -1;
-    int episodeIndex = -1;
-    int elementIndex = -1;
-    int nrScenes = 0;
-    bool containsNonStandardScenes = false;
-
-    ScreenplayElement *lastEpisodeElement = nullptr;
-    ScreenplayElement *lastActElement = nullptr;
-    QString lastEpisodeName;
-    QString lastActName;
-
-    QHash<Scene *, QList<int>> indexListMap;
+    // Numbering is a single forward pass over all elements. Elements before
+    // fromIndex are unchanged, so the pass resumes from the state recorded
+    // right after the element before it.
+    fromIndex = qBound(0, fromIndex, qMin(m_elements.size(), m_sceneNumberingStates.size()));
+    m_sceneNumberingStates.resize(m_elements.size());
 
-    for (ScreenplayElement *element : qAsConst(m_elements))
-        if (element->scene())
-            indexListMap[element->scene()] = QList<int>();
+    SceneNumberingState state =
+            fromIndex > 0 ? m_sceneNumberingStates.at(fromIndex - 1) : SceneNumberingState();
 
-    int index = -1;
-    ScreenplayElement::SceneNumber sceneNumber;
-    for (ScreenplayElement *element : qAsConst(m_elements)) {
-        ++index;
+    for (int index = fromIndex; index < m_elements.size(); index++) {
+        ScreenplayElement *element = m_elements.at(index);
 
         if (element->elementType() == ScreenplayElement::SceneElementType) {
-            if (actIndex < 0 && element->scene()->heading()->isEnabled())
-                ++actIndex;
-            if (episodeIndex < 0 && element->scene()->heading()->isEnabled())
-                ++episodeIndex;
+            if (state.actIndex < 0 && element->scene()->heading()->isEnabled())
+                ++state.actIndex;
+            if (state.episodeIndex < 0 && element->scene()->heading()->isEnabled())
+                ++state.episodeIndex;
 
-            element->setElementIndex(++elementIndex);
-            element->setActIndex(actIndex);
-            element->setEpisodeIndex(episodeIndex);
+            element->setElementIndex(++state.elementIndex);
+            element->setActIndex(state.actIndex);
+            element->setEpisodeIndex(state.episodeIndex);
 
             // This should never happen!
             if (element->scene() == nullptr)
                 element->setScene(new Scene(element));
 
             Scene *scene = element->scene();
-            scene->setAct(lastActElement         ? lastActName
-                                  : actIndex < 0 ? QStringLiteral("No Act")
-                                                 : QStringLiteral("ACT 1"));
-            scene->setActIndex(actIndex);
-            scene->setEpisode(lastEpisodeElement         ? lastEpisodeName
-                                      : episodeIndex < 0 ? QStringLiteral("No Episode")
-                                                         : QStringLiteral("EPISODE 1"));
-            scene->setEpisodeIndex(episodeIndex);
-            indexListMap[scene].append(index);
+            scene->setAct(state.lastActElement         ? state.lastActName
+                                  : state.actIndex < 0 ? QStringLiteral("No Act")
+                                                       : QStringLiteral("ACT 1"));
+            scene->setActIndex(state.actIndex);
+            scene->setEpisode(state.lastEpisodeElement         ? state.lastEpisodeName
+                                      : state.episodeIndex < 0 ? QStringLiteral("No Episode")
+                                                               : QStringLiteral("EPISODE 1"));
+            scene->setEpisodeIndex(state.episodeIndex);
 
             if (scene->heading()->isEnabled()) {
-                ++nrScenes;
-                element->evaluateSceneNumber(sceneNumber, minorAlso);
+                ++state.nrScenes;
+                element->evaluateSceneNumber(state.sceneNumber, minorAlso);
             }
         } else {
             element->setElementIndex(-1);
             if (element->breakType() == Screenplay::Act) {
-                ++actIndex;
-                if (totalActIndex < 0)
-                    ++totalActIndex;
-                ++totalActIndex;
+                ++state.actIndex;
+                if (state.totalActIndex < 0)
+                    ++state.totalActIndex;
+                ++state.totalActIndex;
 
-                lastActElement = element;
-                lastActName = element->breakTitle();
+                state.lastActElement = element;
+                state.lastActName = element->breakTitle();
                 if (!element->breakSubtitle().isEmpty())
-                    lastActName += ": " + element->breakSubtitle();
+                    state.lastActName += ": " + element->breakSubtitle();
             } else if (element->breakType() == Screenplay::Episode) {
-                ++episodeIndex;
+                ++state.episodeIndex;
 
-                actIndex = 0;
+                state.actIndex = 0;
 
-                lastActElement = nullptr;
-                lastEpisodeElement = element;
-                lastEpisodeName = element->breakTitle();
+                state.lastActElement = nullptr;
+                state.lastEpisodeElement = element;
+                state.lastEpisodeName = element->breakTitle();
                 if (!element->breakSubtitle().isEmpty())
-                    lastEpisodeName += ": " + element->breakSubtitle();
+                    state.lastEpisodeName += ": " + element->breakSubtitle();
             }
 
-            element->setActIndex(actIndex);
-            element->setEpisodeIndex(episodeIndex);
+            element->setActIndex(state.actIndex);
+            element->setEpisodeIndex(state.episodeIndex);
         }
 
-        if (!containsNonStandardScenes && element->scene()
+        if (!state.containsNonStandardScenes && element->scene()
             && element->scene()->type() != Scene::Standard)
-            containsNonStandardScenes = true;
-    }
+            state.containsNonStandardScenes = true;
 
-    QHash<Scene *, QList<int>>::const_iterator it = indexListMap.constBegin();
-    QHash<Scene *, QList<int>>::const_iterator end = indexListMap.constEnd();
-    while (it != end) {
-        it.key()->setScreenplayElementIndexList(it.value());
-        ++it;
+        m_sceneNumberingStates[index] = state;
     }
 
-    this->setSceneCount(nrScenes);
-    this->setEpisodeCount(lastEpisodeElement ? episodeIndex + 1 : 0);
-    this->setActCount(lastEpisodeElement ? totalActIndex + 1 : (lastActElement ? actIndex + 1 : 0));
+    this->setSceneCount(state.nrScenes);
+    this->setEpisodeCount(state.lastEpisodeElement ? state.episodeIndex + 1 : 0);
+    this->setActCount(state.lastEpisodeElement
+                              ? state.totalActIndex + 1
+                              : (state.lastActElement ? state.actIndex + 1 : 0));
 
-    this->setHasNonStandardScenes(containsNonStandardScenes);
+    this->setHasNonStandardScenes(state.containsNonStandardScenes);
 }
 
-void Screenplay::evaluateSceneNumbersLater()
+void Screenplay::evaluateSceneNumbersFromLater(int fromIndex)
 {
-    m_sceneNumberEvaluationTimer.start(0, this);
+    m_sceneNumbersDirtyFrom = qMin(m_sceneNumbersDirtyFrom, qMax(fromIndex, 0));
+    this->invalidateLater(SceneNumbersInvalidation);
+}
+
+void Screenplay::updateElementPositions(int fromIndex, const QList<Scene *> &detachedScenes)
+{
+    fromIndex = qMax(fromIndex, 0);
+
+    // Only elements from fromIndex onwards have moved, so only their positions
+    // and the tails of their scenes' index lists need to be rewritten.
+    QHash<Scene *, QList<int>> tailIndexLists;
+    for (Scene *scene : detachedScenes) {
+        if (scene != nullptr && !tailIndexLists.contains(scene))
+            tailIndexLists.insert(scene, QList<int>());
+    }
+
+    for (int index = fromIndex; index < m_elements.size(); index++) {
+        ScreenplayElement *element = m_elements.at(index);
+        element->m_position = index;
+        if (element->elementType() == ScreenplayElement::SceneElementType && element->scene())
+            tailIndexLists[element->scene()].append(index);
+    }
+
+    // Screenplays that only house a scene for ScreenplayAdapter must not
+    // overwrite the scene's index list in the document's screenplay.
+    if (m_scriteDocument != nullptr) {
+        auto it = tailIndexLists.constBegin();
+        auto end = tailIndexLists.constEnd();
+        while (it != end) {
+            QList<int> indexList = it.key()->screenplayElementIndexList();
+            while (!indexList.isEmpty() && indexList.last() >= fromIndex)
+                indexList.removeLast();
+            indexList += it.value();
+            it.key()->setScreenplayElementIndexList(indexList);
+            ++it;
+        }
+    }
+
+    this->evaluateSceneNumbersFromLater(fromIndex);
 }
 
 void Screenplay::validateCurrentElementIndex()
@@ -3257,40 +3415,66 @@ void Screenplay::validateCurrentElementIndex()
 
 void Screenplay::evaluateParagraphCounts()
 {
-    int min = -1, max = -1, avg = 0, total = 0, count = 0;
+    m_paragraphCountTotal = 0;
+    m_paragraphCountSamples = 0;
+    m_paragraphCountHistogram.clear();
+
     for (ScreenplayElement *element : qAsConst(m_elements)) {
+        element->m_reportedParagraphCount = -1;
+
         Scene *scene = element->scene();
         if (scene == nullptr)
             continue;
 
-        if (min < 0)
-            min = scene->elementCount();
-        else
-            min = qMin(min, scene->elementCount());
+        const int count = scene->elementCount();
+        element->m_reportedParagraphCount = count;
+        m_paragraphCountHistogram[count]++;
+        m_paragraphCountTotal += count;
+        ++m_paragraphCountSamples;
+    }
 
-        if (max < 0)
-            max = scene->elementCount();
-        else
-            max = qMax(max, scene->elementCount());
+    this->updateParagraphCounts();
+}
 
-        total += scene->elementCount();
-        ++count;
-    }
+void Screenplay::evaluateParagraphCountsLater()
+{
+    this->invalidateLater(ParagraphCountsInvalidation);
+}
 
-    if (count > 0)
-        avg = qRound(qreal(total) / qreal(count));
-    else
-        avg = 0;
+void Screenplay::reportParagraphCountChange(ScreenplayElement *element)
+{
+    if (element->m_reportedParagraphCount < 0 || element->scene() == nullptr)
+        return;
 
-    m_minimumParagraphCount = min;
-    m_maximumParagraphCount = max;
-    m_averageParagraphCount = avg;
-    emit paragraphCountChanged();
+    const int oldCount = element->m_reportedParagraphCount;
+    const int newCount = element->scene()->elementCount();
+    if (oldCount == newCount)
+        return;
+
+    auto it = m_paragraphCountHistogram.find(oldCount);
+    if (it != m_paragraphCountHistogram.end() && --it.value() == 0)
+        m_paragraphCountHistogram.erase(it);
+    m_paragraphCountHistogram[newCount]++;
+    m_paragraphCountTotal += newCount - oldCount;
+    element->m_reportedParagraphCount = newCount;
+
+    this->updateParagraphCounts();
 }
 
-void Screenplay::evaluateParagraphCountsLater()
+void Screenplay::updateParagraphCounts()
 {
-    m_paragraphCountEvaluationTimer.start(0, this);
+    if (m_paragraphCountHistogram.isEmpty()) {
+        m_minimumParagraphCount = -1;
+        m_maximumParagraphCount = -1;
+        m_averageParagraphCount = 0;
+    } else {
+        m_minimumParagraphCount = m_paragraphCountHistogram.firstKey();
+        m_maximumParagraphCount = m_paragraphCountHistogram.lastKey();
+        m_averageParagraphCount =
+                qRound(qreal(m_paragraphCountTotal) / qreal(m_paragraphCountSamples));
+    }
+
+    emit paragraphCountChanged();
 }
 
 void Screenplay::setHasNonStandardScenes(bool val)
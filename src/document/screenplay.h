@@ -17,6 +17,7 @@
 #include "scene.h"
 #include "modifiable.h"
 #include "execlatertimer.h"
+#include "invalidationscheduler.h"
 #include "qobjectproperty.h"
 
 #include <QJsonArray>
@@ -26,6 +27,7 @@
 class Screenplay;
 class ScriteDocument;
 class AbstractImporter;
+class ScreenplaySearchIndex;
 class ScreenplayTextDocument;
 class AbstractScreenplaySubsetReport;
 
@@ -215,6 +217,8 @@ private:
     void onSceneGroupsChanged() { emit sceneGroupsChanged(this); }
     void setNotes(Notes *val);
     void setAttachments(Attachments *val);
+    void reportWordCountChange();
+    void reportParagraphCountChange();
 
 private:
     friend class Screenplay;
@@ -243,9 +247,18 @@ private:
     ElementType m_elementType = SceneElementType;
     QObjectProperty<Scene> m_scene;
     QObjectProperty<Screenplay> m_screenplay;
+
+    // contributions to Screenplay::wordCount() and paragraph counts, -1 if not counted
+    int m_reportedWordCount = -1;
+    int m_reportedParagraphCount = -1;
+
+    int m_position = -1; // index in Screenplay::elements(), maintained by Screenplay
 };
 
-class Screenplay : public QAbstractListModel, public Modifiable, public QObjectSerializer::Interface
+class Screenplay : public QAbstractListModel,
+                   public Modifiable,
+                   public QObjectSerializer::Interface,
+                   public Invalidatable
 {
     Q_OBJECT
     Q_INTERFACES(QObjectSerializer::Interface)
@@ -543,15 +556,24 @@ public:
 
 protected:
     bool event(QEvent *event);
-    void timerEvent(QTimerEvent *te);
+
+    // Invalidatable interface
+    void flushInvalidation(int key);
+
     void resetActiveScene();
     void onSceneReset(int elementIndex);
     void onScreenplayElementOmittedChanged();
     void evaluateSceneNumbers(bool minorAlso = false);
     void evaluateSceneNumbersLater();
+    void evaluateSceneNumbersFrom(int fromIndex, bool minorAlso = false);
+    void evaluateSceneNumbersFromLater(int fromIndex);
+    void updateElementPositions(int fromIndex,
+                                const QList<Scene *> &detachedScenes = QList<Scene *>());
     void validateCurrentElementIndex();
     void evaluateParagraphCounts();
     void evaluateParagraphCountsLater();
+    void reportParagraphCountChange(ScreenplayElement *element);
+    void updateParagraphCounts();
     void setHasNonStandardScenes(bool val);
     void setHasTitlePageAttributes(bool val);
     void evaluateHasTitlePageAttributes();
@@ -565,7 +587,10 @@ protected:
     void setWordCount(int val);
     void evaluateWordCount();
     void evaluateWordCountLater();
+    void reportWordCountChange(ScreenplayElement *element);
     bool getPasteDataFromClipboard(QJsonObject &clipboardJson) const;
+    bool findSearchCandidates(const QString &text, int flags,
+                              QHash<Scene *, QSet<SceneElement *>> &candidates) const;
     void setHeightHintsAvailable(bool val);
     void evaluateIfHeightHintsAreAvailable();
     void evaluateIfHeightHintsAreAvailableLater();
@@ -588,6 +613,9 @@ private:
     int m_minimumParagraphCount = 0;
     int m_maximumParagraphCount = 0;
     int m_averageParagraphCount = 0;
+    int m_paragraphCountTotal = 0;
+    int m_paragraphCountSamples = 0;
+    QMap<int, int> m_paragraphCountHistogram; // paragraph count -> number of scenes
     bool m_hasTitlePageAttributes = false;
     bool m_heightHintsAvailable = false;
     ScriteDocument *m_scriteDocument = nullptr;
@@ -610,13 +638,35 @@ private:
     int m_actCount = 0;
     int m_sceneCount = 0;
     int m_wordCount = 0;
+    mutable ScreenplaySearchIndex *m_searchIndex = nullptr;
 
-    ExecLaterTimer m_wordCountTimer;
-    ExecLaterTimer m_updateBreakTitlesTimer;
-    ExecLaterTimer m_sceneNumberEvaluationTimer;
-    ExecLaterTimer m_paragraphCountEvaluationTimer;
-    ExecLaterTimer m_evalHeightHintsAvailableTimer;
-    ExecLaterTimer m_selectedElementsOmitStatusChangedTimer;
+    // State of the scene numbering pass after each element, so that the pass
+    // can resume from the first element that changed.
+    struct SceneNumberingState
+    {
+        int actIndex = -1;
+        int totalActIndex = -1;
+        int episodeIndex = -1;
+        int elementIndex = -1;
+        int nrScenes = 0;
+        bool containsNonStandardScenes = false;
+        ScreenplayElement *lastEpisodeElement = nullptr;
+        ScreenplayElement *lastActElement = nullptr;
+        QString lastEpisodeName;
+        QString lastActName;
+        ScreenplayElement::SceneNumber sceneNumber;
+    };
+    QVector<SceneNumberingState> m_sceneNumberingStates;
+    int m_sceneNumbersDirtyFrom = 0;
+
+    enum Invalidation {
+        WordCountInvalidation,
+        BreakTitlesInvalidation,
+        SceneNumbersInvalidation,
+        ParagraphCountsInvalidation,
+        HeightHintsAvailableInvalidation,
+        SelectedElementsOmitStatusInvalidation
+    };
 };
 
 /**
@@ -0,0 +1,215 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "scene.h"
+#include "screenplay.h"
+#include "screenplaysearchindex.h"
+
+#include <algorithm>
+
+/**
+ * Trigrams are made of case folded UTF-16 code units, three of which are packed into the
+ * lower 48 bits of a 64-bit key. Folding case means that one index serves both case
+ * sensitive and insensitive searches; matches found through the index are always verified
+ * against the actual text anyway.
+ */
+static void collectTrigrams(const QString &text, QVector<quint64> &trigrams)
+{
+    trigrams.clear();
+
+    const int length = text.length();
+    if (length < 3)
+        return;
+
+    trigrams.reserve(length - 2);
+
+    quint64 key = 0;
+    for (int i = 0; i < length; i++) {
+        key = ((key << 16) | text.at(i).toCaseFolded().unicode()) & Q_UINT64_C(0xFFFFFFFFFFFF);
+        if (i >= 2)
+            trigrams.append(key);
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+ScreenplaySearchIndex::ScreenplaySearchIndex(Screenplay *parent) : QObject(parent) { }
+
+ScreenplaySearchIndex::~ScreenplaySearchIndex() { }
+
+void ScreenplaySearchIndex::addScene(Scene *scene)
+{
+    if (scene == nullptr || m_sceneElements.contains(scene))
+        return;
+
+    m_sceneElements.insert(scene, QSet<SceneElement *>());
+
+    connect(scene, &Scene::sceneElementChanged, this,
+            [=](SceneElement *element, Scene::SceneElementChangeType type) {
+                this->onSceneElementChanged(scene, element, type);
+            });
+    connect(scene, &Scene::aboutToRemoveSceneElement, this,
+            &ScreenplaySearchIndex::onAboutToRemoveSceneElement);
+    connect(scene, &Scene::elementCountChanged, this, [=]() { this->syncScene(scene); });
+    connect(scene, &Scene::sceneReset, this, [=]() { this->syncScene(scene); });
+    connect(scene, &Scene::aboutToDelete, this, &ScreenplaySearchIndex::removeScene);
+
+    this->syncScene(scene);
+}
+
+void ScreenplaySearchIndex::removeScene(Scene *scene)
+{
+    auto it = m_sceneElements.find(scene);
+    if (it == m_sceneElements.end())
+        return;
+
+    const QSet<SceneElement *> elements = it.value();
+    for (SceneElement *element : elements)
+        this->unindexElement(element);
+
+    m_sceneElements.remove(scene);
+    disconnect(scene, nullptr, this, nullptr);
+}
+
+bool ScreenplaySearchIndex::findCandidates(const QString &text,
+                                           QHash<Scene *, QSet<SceneElement *>> &candidates) const
+{
+    candidates.clear();
+
+    // Case folding of characters outside the BMP depends on both surrogates, which
+    // trigrams of single code units cannot represent.
+    for (const QChar ch : text) {
+        if (ch.isSurrogate())
+            return false;
+    }
+
+    QVector<quint64> trigrams;
+    collectTrigrams(text, trigrams);
+    if (trigrams.isEmpty())
+        return false;
+
+    QVector<const QSet<SceneElement *> *> postings;
+    postings.reserve(trigrams.size());
+    for (const quint64 trigram : qAsConst(trigrams)) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd())
+            return true; // no paragraph contains this trigram, and hence the text
+        postings.append(&it.value());
+    }
+
+    // Walk the rarest trigram's paragraphs and keep those having all the other trigrams.
+    std::sort(postings.begin(), postings.end(),
+              [](const QSet<SceneElement *> *a, const QSet<SceneElement *> *b) {
+                  return a->size() < b->size();
+              });
+
+    for (SceneElement *element : *postings.first()) {
+        bool hasAllTrigrams = true;
+        for (int i = 1; i < postings.size() && hasAllTrigrams; i++)
+            hasAllTrigrams = postings.at(i)->contains(element);
+        if (hasAllTrigrams)
+            candidates[m_elements.value(element).scene].insert(element);
+    }
+
+    return true;
+}
+
+void ScreenplaySearchIndex::onSceneElementChanged(Scene *scene, SceneElement *element, int type)
+{
+    if (type == Scene::ElementTextChange && element->scene() == scene)
+        this->indexElement(scene, element);
+}
+
+void ScreenplaySearchIndex::onAboutToRemoveSceneElement(SceneElement *element)
+{
+    this->unindexElement(element);
+}
+
+void ScreenplaySearchIndex::indexElement(Scene *scene, SceneElement *element)
+{
+    IndexedElement &indexed = m_elements[element];
+    if (indexed.scene != scene) {
+        if (indexed.scene != nullptr)
+            m_sceneElements[indexed.scene].remove(element);
+        indexed.scene = scene;
+        m_sceneElements[scene].insert(element);
+    }
+
+    QVector<quint64> trigrams;
+    collectTrigrams(element->text(), trigrams);
+
+    // Only postings of trigrams that were added or dropped by the edit are touched.
+    auto oldIt = indexed.trigrams.constBegin();
+    auto oldEnd = indexed.trigrams.constEnd();
+    auto newIt = trigrams.constBegin();
+    auto newEnd = trigrams.constEnd();
+    while (oldIt != oldEnd || newIt != newEnd) {
+        if (newIt == newEnd || (oldIt != oldEnd && *oldIt < *newIt)) {
+            auto it = m_postings.find(*oldIt);
+            if (it != m_postings.end()) {
+                it.value().remove(element);
+                if (it.value().isEmpty())
+                    m_postings.erase(it);
+            }
+            ++oldIt;
+        } else if (oldIt == oldEnd || *newIt < *oldIt) {
+            m_postings[*newIt].insert(element);
+            ++newIt;
+        } else {
+            ++oldIt;
+            ++newIt;
+        }
+    }
+
+    indexed.trigrams = trigrams;
+}
+
+void ScreenplaySearchIndex::unindexElement(SceneElement *element)
+{
+    auto it = m_elements.find(element);
+    if (it == m_elements.end())
+        return;
+
+    for (const quint64 trigram : qAsConst(it.value().trigrams)) {
+        auto pit = m_postings.find(trigram);
+        if (pit != m_postings.end()) {
+            pit.value().remove(element);
+            if (pit.value().isEmpty())
+                m_postings.erase(pit);
+        }
+    }
+
+    auto sit = m_sceneElements.find(it.value().scene);
+    if (sit != m_sceneElements.end())
+        sit.value().remove(element);
+
+    m_elements.erase(it);
+}
+
+void ScreenplaySearchIndex::syncScene(Scene *scene)
+{
+    // All paragraphs are reindexed, because a reset may change text without reporting it
+    // paragraph by paragraph. Unchanged paragraphs only cost a trigram comparison.
+    QSet<SceneElement *> stale = m_sceneElements.value(scene);
+
+    const int nrElements = scene->elementCount();
+    for (int i = 0; i < nrElements; i++) {
+        SceneElement *element = scene->elementAt(i);
+        stale.remove(element);
+        this->indexElement(scene, element);
+    }
+
+    for (SceneElement *element : qAsConst(stale))
+        this->unindexElement(element);
+}
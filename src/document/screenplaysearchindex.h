@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef SCREENPLAYSEARCHINDEX_H
+#define SCREENPLAYSEARCHINDEX_H
+
+#include <QSet>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+class Scene;
+class Screenplay;
+class SceneElement;
+
+/**
+ * Trigram index over paragraphs of scenes in a screenplay.
+ *
+ * Scenes are added to the index as they are looked up, after which the index follows
+ * changes to their paragraphs. Searching consults the index for paragraphs that may
+ * contain the search string, so that only those paragraphs have to be scanned.
+ */
+class ScreenplaySearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScreenplaySearchIndex(Screenplay *parent = nullptr);
+    ~ScreenplaySearchIndex();
+
+    void addScene(Scene *scene);
+    void removeScene(Scene *scene);
+    bool containsScene(Scene *scene) const { return m_sceneElements.contains(scene); }
+
+    /**
+     * Looks up paragraphs that may contain text, with or without case sensitivity.
+     * Paragraphs left out of candidates are guaranteed not to contain it. Returns false
+     * if the index cannot narrow down the search, for example when text is shorter than
+     * a trigram, in which case all paragraphs must be scanned.
+     */
+    bool findCandidates(const QString &text,
+                        QHash<Scene *, QSet<SceneElement *>> &candidates) const;
+
+private:
+    void onSceneElementChanged(Scene *scene, SceneElement *element, int type);
+    void onAboutToRemoveSceneElement(SceneElement *element);
+    void indexElement(Scene *scene, SceneElement *element);
+    void unindexElement(SceneElement *element);
+    void syncScene(Scene *scene);
+
+private:
+    struct IndexedElement
+    {
+        Scene *scene = nullptr;
+        QVector<quint64> trigrams; // sorted, unique
+    };
+    QHash<SceneElement *, IndexedElement> m_elements;
+    QHash<Scene *, QSet<SceneElement *>> m_sceneElements;
+    QHash<quint64, QSet<SceneElement *>> m_postings;
+};
+
+#endif // SCREENPLAYSEARCHINDEX_H
@@ -19,6 +19,8 @@
 #include <QDate>
 #include <QDateTime>
 #include <QDir>
+#include <QFontDatabase>
+#include <QFutureWatcher>
 #include <QGraphicsRectItem>
 #include <QGraphicsScene>
 #include <QJsonDocument>
@@ -36,6 +38,7 @@
 #include <QTextCursor>
 #include <QTextTable>
 #include <QUrl>
+#include <QtConcurrentRun>
 #include <QtDebug>
 #include <QtMath>
 
@@ -260,6 +263,7 @@ void ScreenplayTextDocument::setTextDocument(QTextDocument *val)
 
     m_textDocument = val ? val : new QTextDocument(this);
     m_textDocument->setUndoRedoEnabled(false);
+    this->connectToTextDocumentSignals();
     this->loadScreenplayLater();
 
     emit textDocumentChanged();
@@ -323,6 +327,7 @@ void ScreenplayTextDocument::resetTextDocument()
 {
     m_textDocument = new QTextDocument(this);
     m_textDocument->setUndoRedoEnabled(false);
+    this->connectToTextDocumentSignals();
     this->loadScreenplayLater();
     emit textDocumentChanged();
 }
@@ -517,6 +522,24 @@ void ScreenplayTextDocument::setIncludeMoreAndContdMarkers(bool val)
     this->loadScreenplayLater();
 }
 
+void ScreenplayTextDocument::setLayoutInBackground(bool val)
+{
+    if (m_layoutInBackground == val)
+        return;
+
+    m_layoutInBackground = val;
+    emit layoutInBackgroundChanged();
+
+    // Positions laid out in one mode mean nothing in the other.
+    m_pageBoundaries.clear();
+    m_pageBoundariesDirtyRange.all = true;
+    m_backgroundFrameLayouts.clear();
+    m_backgroundLayoutDocumentLength = 0;
+    m_screenplayModificationTracker.track(nullptr);
+
+    this->loadScreenplayLater();
+}
+
 void ScreenplayTextDocument::setSecondsPerPage(int val)
 {
     val = qBound(15, val, 300);
@@ -606,24 +629,18 @@ QList<QPair<int, int>> ScreenplayTextDocument::pageBreaksFor(ScreenplayElement *
     if (element == nullptr)
         return ret;
 
-    QTextFrame *frame = this->findTextFrame(element);
-    if (frame == nullptr)
-        return ret;
-
     // We need to know three positions within each scene frame.
     // 1. Start of the frame
     // 2. Start of the first paragraph in the scene (after the scene heading)
     // 3. End of the scene frame
-    QTextCursor cursor = frame->firstCursorPosition();
-    QTextBlock block = cursor.block();
-    ScreenplayParagraphBlockData *blockData = ScreenplayParagraphBlockData::get(block);
-    if (blockData && blockData->elementType() == SceneElement::Heading)
-        block = block.next();
+    ScreenplayTextFrameLayout frameLayout;
+    if (!this->findFrameLayout(element, frameLayout))
+        return ret;
 
     // This is the range of cursor positions inside the frame
-    int sceneHeadingStart = frame->firstPosition();
-    int paragraphStart = block.position();
-    int paragraphEnd = frame->lastPosition();
+    int sceneHeadingStart = frameLayout.firstPosition;
+    int paragraphStart = frameLayout.paragraphPosition;
+    int paragraphEnd = frameLayout.lastPosition;
 
     // This method includes 'pageBorderPosition' and 'pageNumber' in the returned
     // list If pageBorderPosition lies within the frame, then it is included in
@@ -679,9 +696,16 @@ qreal ScreenplayTextDocument::lengthInPixels(ScreenplayElement *from, Screenplay
     const int fromIndex = m_screenplay->indexOfElement(from);
     const int toIndex = to ? m_screenplay->indexOfElement(to) : fromIndex;
 
+    const bool inBackground = this->canLayoutInBackground();
+
     qreal ret = 0;
     for (int i = fromIndex; i <= toIndex; i++) {
         ScreenplayElement *element = m_screenplay->elementAt(i);
+        if (inBackground) {
+            ret += m_backgroundFrameLayouts.value(element).height;
+            continue;
+        }
+
         QTextFrame *frame = this->findTextFrame(element);
         if (frame == nullptr)
             continue;
@@ -1054,6 +1078,9 @@ void ScreenplayTextDocument::timerEvent(QTimerEvent *event)
     } else if (event->timerId() == m_sceneResetTimer.timerId()) {
         m_sceneResetTimer.stop();
         this->processSceneResetList();
+    } else if (event->timerId() == m_backgroundLayoutTimer.timerId()) {
+        m_backgroundLayoutTimer.stop();
+        this->layoutInBackground();
     } else
         QObject::timerEvent(event);
 }
@@ -1063,6 +1090,8 @@ void ScreenplayTextDocument::init()
     if (m_textDocument == nullptr)
         m_textDocument = new QTextDocument(this);
 
+    this->connectToTextDocumentSignals();
+
 #ifdef DISPLAY_DOCUMENT_IN_TEXTEDIT
     m_sceneFrameFormat.setBorderStyle(QTextFrameFormat::BorderStyle_Solid);
     m_sceneFrameFormat.setBorderBrush(QBrush(Qt::black));
@@ -1134,6 +1163,8 @@ void ScreenplayTextDocument::setCurrentPageAndPosition(int page, qreal pos)
 
 void ScreenplayTextDocument::loadScreenplay()
 {
+    PROFILE_THIS_FUNCTION;
+
 #ifdef DISPLAY_DOCUMENT_IN_TEXTEDIT
     static QTextEdit *textEdit = nullptr;
     if (m_purpose == ForDisplay) {
@@ -1148,6 +1179,16 @@ void ScreenplayTextDocument::loadScreenplay()
     }
 #endif // DISPLAY_DOCUMENT_IN_TEXTEDIT
 
+    // The text document is not loaded at all, when it is laid out in the background. So
+    // there is nothing here to keep the UI busy with.
+    if (this->canLayoutInBackground()) {
+        if (m_componentComplete) {
+            this->layoutInBackgroundLater();
+            emit updateFinished();
+        }
+        return;
+    }
+
     HourGlass hourGlass;
 
     if (m_updating || !m_componentComplete) // so that we avoid recursive updates
@@ -1167,6 +1208,7 @@ void ScreenplayTextDocument::loadScreenplay()
     m_textDocument->setProperty("#characterImageResourceUrls", QVariant());
     m_sceneResetTimer.stop();
     m_pageBoundaryEvalTimer.stop();
+    m_pageBoundariesDirtyRange.all = true;
 
     if (m_screenplay == nullptr)
         return;
@@ -1238,80 +1280,27 @@ void ScreenplayTextDocument::loadScreenplay()
     if (injection != nullptr)
         injection->inject(cursor, AbstractScreenplayTextDocumentInjectionInterface::AfterTitlePage);
 
-    bool hasEpisdoes = m_screenplay->episodeCount() > 0;
-    if (m_screenplay->scriteDocument() == nullptr) {
-        const QList<ScreenplayElement *> allElements = m_screenplay->getElements();
-
-        QList<ScreenplayElement *> episodeElements;
-        std::copy_if(allElements.begin(), allElements.end(), std::back_inserter(episodeElements),
-                     [](ScreenplayElement *e) {
-                         return e->elementType() == ScreenplayElement::BreakElementType
-                                 && e->breakType() == Screenplay::Episode;
-                     });
-
-        hasEpisdoes = !episodeElements.isEmpty();
-    }
+    const bool hasEpisdoes = this->screenplayHasEpisodes();
 
     const ScreenplayElement *lastPrintedElement = nullptr;
 
-    auto printActBreak = [=](QTextCursor &cursor, const ScreenplayElement *element,
-                             bool addPageBreak) {
-        QTextBlockFormat actBlockFormat;
-        if (addPageBreak)
-            actBlockFormat.setPageBreakPolicy(QTextBlockFormat::PageBreak_AlwaysBefore);
-        else {
-            const SceneElementFormat *firstParaFormat =
-                    m_formatting->elementFormat(SceneElement::Heading);
-            const qreal pageWidth = m_formatting->pageLayout()->contentWidth();
-            const QTextBlockFormat blockFormat =
-                    firstParaFormat->createBlockFormat(Qt::Alignment(), &pageWidth);
-            actBlockFormat.setTopMargin(blockFormat.topMargin());
-        }
-
+    auto printBreak = [&](QTextCursor &cursor, const ScreenplayElement *element,
+                          bool addPageBreak) {
+        const ScreenplayTextBlockContent block =
+                this->breakBlock(element, addPageBreak, hasEpisdoes, lastPrintedElement);
         cursor.insertBlock();
-        cursor.setBlockFormat(actBlockFormat);
-
-        QTextCharFormat actCharFormat;
-        actCharFormat.setFontPointSize(m_textDocument->defaultFont().pointSize());
-        actCharFormat.setFontWeight(QFont::ExtraBold);
-        cursor.setCharFormat(actCharFormat);
-
-        if (hasEpisdoes
-            && (!lastPrintedElement
-                || lastPrintedElement->elementType() != ScreenplayElement::BreakElementType))
-            cursor.insertText(QStringLiteral("Episode ")
-                              + QString::number(element->episodeIndex() + 1)
-                              + QStringLiteral(", "));
-        cursor.insertText(element->breakTitle());
-
-        if (!element->breakSubtitle().isEmpty())
-            cursor.insertText(QStringLiteral(": ") + element->breakSubtitle().toUpper());
+        cursor.setBlockFormat(block.blockFormat);
+        cursor.setCharFormat(block.charFormat);
+        cursor.insertText(block.text);
     };
 
-    const int fsi = m_screenplay->firstSceneIndex();
     for (int i = 0; i < m_screenplay->elementCount(); i++) {
         const ScreenplayElement *element = m_screenplay->elementAt(i);
 
         if (!m_printEachSceneOnANewPage) {
             if (hasEpisdoes && element->elementType() == ScreenplayElement::BreakElementType
                 && element->breakType() == Screenplay::Episode) {
-                QTextBlockFormat episodeBlockFormat;
-                if (i > 0)
-                    episodeBlockFormat.setPageBreakPolicy(QTextBlockFormat::PageBreak_AlwaysBefore);
-
-                cursor.insertBlock();
-                cursor.setBlockFormat(episodeBlockFormat);
-
-                QTextCharFormat episodeCharFormat;
-                episodeCharFormat.setFontPointSize(m_textDocument->defaultFont().pointSize() + 2);
-                episodeCharFormat.setFontWeight(QFont::ExtraBold);
-                cursor.setCharFormat(episodeCharFormat);
-
-                cursor.insertText(element->breakTitle().toUpper());
-
-                if (!element->breakSubtitle().isEmpty())
-                    cursor.insertText(QStringLiteral(": ") + element->breakSubtitle().toUpper());
-
+                printBreak(cursor, element, i > 0);
                 lastPrintedElement = element;
                 continue;
             }
@@ -1319,7 +1308,7 @@ void ScreenplayTextDocument::loadScreenplay()
             if (m_printEachActOnANewPage
                 && element->elementType() == ScreenplayElement::BreakElementType
                 && element->breakType() == Screenplay::Act) {
-                printActBreak(cursor, element, i > 0);
+                printBreak(cursor, element, i > 0);
                 lastPrintedElement = element;
                 continue;
             }
@@ -1327,7 +1316,7 @@ void ScreenplayTextDocument::loadScreenplay()
 
         if (m_includeActBreaks && element->elementType() == ScreenplayElement::BreakElementType
             && element->breakType() == Screenplay::Act && lastPrintedElement != element) {
-            printActBreak(cursor, element, false);
+            printBreak(cursor, element, false);
             lastPrintedElement = element;
             continue;
         }
@@ -1335,28 +1324,10 @@ void ScreenplayTextDocument::loadScreenplay()
         if (element->elementType() != ScreenplayElement::SceneElementType)
             continue;
 
-        QTextFrameFormat frameFormat = m_sceneFrameFormat;
-        const Scene *scene = element->scene();
-        if (scene != nullptr && (i > fsi || element != lastPrintedElement)) {
-            SceneElement::Type firstParaType = SceneElement::Heading;
-            if (!scene->heading()->isEnabled() && scene->elementCount()) {
-                SceneElement *firstPara = scene->elementAt(0);
-                firstParaType = firstPara->type();
-            }
-
-            const SceneElementFormat *firstParaFormat = m_formatting->elementFormat(firstParaType);
-            const qreal pageWidth = m_formatting->pageLayout()->contentWidth();
-            const QTextBlockFormat blockFormat =
-                    firstParaFormat->createBlockFormat(Qt::Alignment(), &pageWidth);
-            frameFormat.setTopMargin(blockFormat.topMargin());
-        }
-
-        if (i > 0 && m_printEachSceneOnANewPage)
-            frameFormat.setPageBreakPolicy(QTextFrameFormat::PageBreak_AlwaysBefore);
-
         // Each screenplay element (or scene) has its own frame. That makes
         // moving them in one bunch easy.
-        QTextFrame *frame = cursor.insertFrame(frameFormat);
+        QTextFrame *frame =
+                cursor.insertFrame(this->sceneFrameFormat(element, i, lastPrintedElement));
         this->registerTextFrame(element, frame);
         this->loadScreenplayElement(element, cursor);
 
@@ -1655,22 +1626,35 @@ void ScreenplayTextDocument::connectToScreenplaySignals()
     if (m_screenplay == nullptr || !m_syncEnabled || m_connectedToScreenplaySignals)
         return;
 
-    connect(m_screenplay, &Screenplay::elementMoved, this, &ScreenplayTextDocument::onSceneMoved,
-            Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::modelReset, this, &ScreenplayTextDocument::onScreenplayReset,
-            Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::elementRemoved, this,
-            &ScreenplayTextDocument::onSceneRemoved, Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::elementInserted, this,
-            &ScreenplayTextDocument::onSceneInserted, Qt::UniqueConnection);
+    if (this->canLayoutInBackground()) {
+        // There are no frames to update, any change simply calls for a fresh snapshot.
+        connect(m_screenplay, &Screenplay::elementsChanged, this,
+                &ScreenplayTextDocument::layoutInBackgroundLater, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::screenplayChanged, this,
+                &ScreenplayTextDocument::layoutInBackgroundLater, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementOmitted, this,
+                &ScreenplayTextDocument::layoutInBackgroundLater, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementIncluded, this,
+                &ScreenplayTextDocument::layoutInBackgroundLater, Qt::UniqueConnection);
+    } else {
+        connect(m_screenplay, &Screenplay::elementMoved, this,
+                &ScreenplayTextDocument::onSceneMoved, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::modelReset, this,
+                &ScreenplayTextDocument::onScreenplayReset, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementRemoved, this,
+                &ScreenplayTextDocument::onSceneRemoved, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementInserted, this,
+                &ScreenplayTextDocument::onSceneInserted, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::modelAboutToBeReset, this,
+                &ScreenplayTextDocument::onScreenplayAboutToReset, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementOmitted, this,
+                &ScreenplayTextDocument::onSceneOmitted, Qt::UniqueConnection);
+        connect(m_screenplay, &Screenplay::elementIncluded, this,
+                &ScreenplayTextDocument::onSceneIncluded, Qt::UniqueConnection);
+    }
+
     connect(m_screenplay, &Screenplay::activeSceneChanged, this,
             &ScreenplayTextDocument::onActiveSceneChanged, Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::modelAboutToBeReset, this,
-            &ScreenplayTextDocument::onScreenplayAboutToReset, Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::elementOmitted, this,
-            &ScreenplayTextDocument::onSceneOmitted, Qt::UniqueConnection);
-    connect(m_screenplay, &Screenplay::elementIncluded, this,
-            &ScreenplayTextDocument::onSceneIncluded, Qt::UniqueConnection);
 
     for (int i = 0; i < m_screenplay->elementCount(); i++) {
         ScreenplayElement *element = m_screenplay->elementAt(i);
@@ -1728,6 +1712,14 @@ void ScreenplayTextDocument::disconnectFromScreenplaySignals()
                &ScreenplayTextDocument::onSceneOmitted);
     disconnect(m_screenplay, &Screenplay::elementIncluded, this,
                &ScreenplayTextDocument::onSceneIncluded);
+    disconnect(m_screenplay, &Screenplay::elementsChanged, this,
+               &ScreenplayTextDocument::layoutInBackgroundLater);
+    disconnect(m_screenplay, &Screenplay::screenplayChanged, this,
+               &ScreenplayTextDocument::layoutInBackgroundLater);
+    disconnect(m_screenplay, &Screenplay::elementOmitted, this,
+               &ScreenplayTextDocument::layoutInBackgroundLater);
+    disconnect(m_screenplay, &Screenplay::elementIncluded, this,
+               &ScreenplayTextDocument::layoutInBackgroundLater);
 
     for (int i = 0; i < m_screenplay->elementCount(); i++) {
         ScreenplayElement *element = m_screenplay->elementAt(i);
@@ -1767,6 +1759,14 @@ void ScreenplayTextDocument::connectToSceneSignals(Scene *scene)
     if (scene == nullptr)
         return;
 
+    if (this->canLayoutInBackground()) {
+        connect(scene, &Scene::sceneChanged, this,
+                &ScreenplayTextDocument::layoutInBackgroundLater, Qt::UniqueConnection);
+        connect(scene, &Scene::sceneReset, this, &ScreenplayTextDocument::layoutInBackgroundLater,
+                Qt::UniqueConnection);
+        return;
+    }
+
     connect(scene, &Scene::sceneReset, this, &ScreenplayTextDocument::onSceneReset,
             Qt::UniqueConnection);
     connect(scene, &Scene::modelReset, this, &ScreenplayTextDocument::onSceneResetModel,
@@ -1804,6 +1804,9 @@ void ScreenplayTextDocument::disconnectFromSceneSignals(Scene *scene)
                &ScreenplayTextDocument::onSceneElementChanged);
     disconnect(scene, &Scene::modelAboutToBeReset, this,
                &ScreenplayTextDocument::onSceneAboutToResetModel);
+    disconnect(scene, &Scene::sceneChanged, this,
+               &ScreenplayTextDocument::layoutInBackgroundLater);
+    disconnect(scene, &Scene::sceneReset, this, &ScreenplayTextDocument::layoutInBackgroundLater);
 
     SceneHeading *heading = scene->heading();
     disconnect(heading, &SceneHeading::textChanged, this,
@@ -2156,39 +2159,33 @@ void ScreenplayTextDocument::evaluateCurrentPageAndPosition()
         return;
     }
 
-    if (m_screenplay->currentElementIndex() < 0 || m_textDocument->isEmpty()) {
+    const bool inBackground = this->canLayoutInBackground();
+    if (m_screenplay->currentElementIndex() < 0 || (!inBackground && m_textDocument->isEmpty())) {
         this->setCurrentPageAndPosition(0, 0);
         return;
     }
 
     ScreenplayElement *element = m_screenplay->elementAt(m_screenplay->currentElementIndex());
-    QTextFrame *frame = element && element->scene() && element->scene() == m_activeScene
-            ? this->findTextFrame(element)
-            : nullptr;
-    if (frame == nullptr) {
+    ScreenplayTextFrameLayout frameLayout;
+    if (element == nullptr || element->scene() != m_activeScene
+        || !this->findFrameLayout(element, frameLayout)) {
         this->setCurrentPageAndPosition(0, 0);
         return;
     }
 
-    QTextCursor endCursor(m_textDocument);
-    endCursor.movePosition(QTextCursor::End);
-
-    if (endCursor.position() == 0) {
+    const int documentLength = inBackground ? m_backgroundLayoutDocumentLength
+                                            : m_textDocument->characterCount() - 1;
+    if (documentLength <= 0) {
         this->setCurrentPageAndPosition(0, 0);
         return;
     }
 
-    const int documentLength = endCursor.position();
-    if (documentLength > 0 && m_pageBoundaries.isEmpty())
+    // Background layouts publish page boundaries along with frame layouts, they are never
+    // evaluated on demand.
+    if (!inBackground && m_pageBoundaries.isEmpty())
         this->evaluatePageBoundaries(false);
 
-    QTextCursor userCursor = frame->firstCursorPosition();
-    QTextBlock block = userCursor.block();
-    ScreenplayParagraphBlockData *blockData = ScreenplayParagraphBlockData::get(block);
-    if (blockData && blockData->elementType() == SceneElement::Heading)
-        block = block.next();
-
-    const int cursorPosition = m_activeScene->cursorPosition() + block.position();
+    const int cursorPosition = m_activeScene->cursorPosition() + frameLayout.paragraphPosition;
     for (int i = 0; i < m_pageBoundaries.size(); i++) {
         const QPair<int, int> pgBoundary = m_pageBoundaries.at(i);
         if (cursorPosition >= pgBoundary.first - 1 && cursorPosition < pgBoundary.second) {
@@ -2202,20 +2199,48 @@ void ScreenplayTextDocument::evaluateCurrentPageAndPosition()
     this->setCurrentPageAndPosition(m_pageCount, 1.0);
 }
 
+static QRectF pageContentsRect(const QRectF &paperRect, const QMarginsF &pageMargins,
+                               int pageIndex)
+{
+    return QRectF(0, pageIndex * paperRect.height(), paperRect.width(), paperRect.height())
+            .adjusted(pageMargins.left(), pageMargins.top(), -pageMargins.right(),
+                      -pageMargins.bottom());
+}
+
 void ScreenplayTextDocument::evaluatePageBoundaries(bool revalCurrentPageAndPosition)
 {
+    PROFILE_THIS_FUNCTION;
+
     // NOTE: Please do not call this function from anywhere other than
     // timerEvent(), while handling m_pageBoundaryEvalTimer
+    if (this->canLayoutInBackground()) {
+        this->layoutInBackgroundLater();
+        return;
+    }
+
     QList<QPair<int, int>> pgBoundaries;
 
     if (m_formatting != nullptr && m_textDocument != nullptr && m_screenplay != nullptr) {
-        m_textDocument->setDefaultFont(m_formatting->defaultFont());
+        PageBoundariesDirtyRange &dirtyRange = m_pageBoundariesDirtyRange;
+
+        // Changing font or page layout relayouts the whole document, after which none of
+        // the previously evaluated boundaries can be trusted.
+        if (m_textDocument->defaultFont() != m_formatting->defaultFont()) {
+            m_textDocument->setDefaultFont(m_formatting->defaultFont());
+            dirtyRange.all = true;
+        }
+
+        const QSizeF pageSize = m_textDocument->pageSize();
+        const QTextFrameFormat rootFrameFormat = m_textDocument->rootFrame()->frameFormat();
         m_formatting->pageLayout()->configure(m_textDocument);
+        if (pageSize != m_textDocument->pageSize()
+            || rootFrameFormat != m_textDocument->rootFrame()->frameFormat())
+            dirtyRange.all = true;
 
         const ScreenplayPageLayout *pageLayout = m_formatting->pageLayout();
         const QMarginsF pageMargins = pageLayout->margins();
 
-        QRectF paperRect = pageLayout->paperRect();
+        const QRectF paperRect = pageLayout->paperRect();
         QAbstractTextDocumentLayout *layout = m_textDocument->documentLayout();
 
         const int endCursorPosition = m_textDocument->characterCount() - 1;
@@ -2224,43 +2249,85 @@ void ScreenplayTextDocument::evaluatePageBoundaries(bool revalCurrentPageAndPosi
 
         const int pageCount = m_textDocument->pageCount();
         int pageIndex = 0;
-        while (pageIndex < pageCount) {
-            paperRect = QRectF(0, pageIndex * paperRect.height(), paperRect.width(),
-                               paperRect.height());
-            const QRectF contentsRect =
-                    paperRect.adjusted(pageMargins.left(), pageMargins.top(), -pageMargins.right(),
-                                       -pageMargins.bottom());
-            const int firstPosition = pgBoundaries.isEmpty()
-                    ? layout->hitTest(contentsRect.topLeft(), Qt::FuzzyHit)
-                    : pgBoundaries.last().second + 1;
-            const int lastPosition = pageIndex == pageCount - 1
-                    ? endCursorPosition
-                    : layout->hitTest(contentsRect.bottomRight(), Qt::FuzzyHit);
-            pgBoundaries << qMakePair(firstPosition,
-                                      lastPosition >= 0 ? lastPosition : endCursorPosition);
-
-            ++pageIndex;
-
-            if (pageIndex == pageCount) {
-                ScreenplayElement *lastElement =
-                        m_screenplay->elementAt(m_screenplay->elementCount() - 1);
-                if (lastElement == nullptr)
-                    fpageCount = 0.01;
-                else {
-                    QTextFrame *lastFrame = this->findTextFrame(lastElement);
-                    if (lastFrame == nullptr)
-                        fpageCount = pageCount;
-                    else {
-                        const QRectF lastFrameRect = layout->frameBoundingRect(lastFrame);
-                        fpageCount = pageCount - 1;
-                        fpageCount += (lastFrameRect.bottom() - contentsRect.top())
-                                / contentsRect.height();
+
+        // Pages that end before the first edited block are laid out exactly as before.
+        // We step back one more page, because a block edited at the top of a page can
+        // pull lines from or push lines onto the page before it.
+        const QList<QPair<int, int>> oldPgBoundaries = m_pageBoundaries;
+        if (!dirtyRange.all && dirtyRange.from >= 0) {
+            const int dirtyFrom = m_textDocument->findBlock(dirtyRange.from).position();
+            while (pageIndex < oldPgBoundaries.size() - 1 && pageIndex < pageCount - 1
+                   && oldPgBoundaries.at(pageIndex).second < dirtyFrom)
+                ++pageIndex;
+            pageIndex = qMax(pageIndex - 1, 0);
+            pgBoundaries = oldPgBoundaries.mid(0, pageIndex);
+        } else if (!dirtyRange.all)
+            pgBoundaries = oldPgBoundaries; // nothing was edited since last time
+
+        if (pgBoundaries.size() != pageCount || dirtyRange.all) {
+            pgBoundaries = pgBoundaries.mid(0, pageIndex);
+
+            while (pageIndex < pageCount) {
+                const QRectF contentsRect = pageContentsRect(paperRect, pageMargins, pageIndex);
+                const int firstPosition = pgBoundaries.isEmpty()
+                        ? layout->hitTest(contentsRect.topLeft(), Qt::FuzzyHit)
+                        : pgBoundaries.last().second + 1;
+
+                // Once a page past the edits starts where it used to start (shifted by the
+                // number of characters added or removed), the rest of the document is
+                // paginated just like before and need not be hit-tested again.
+                if (!dirtyRange.all && pageIndex > 0 && firstPosition > dirtyRange.to) {
+                    const int oldFirstPosition = firstPosition - dirtyRange.delta;
+                    const auto it = std::lower_bound(
+                            oldPgBoundaries.constBegin(), oldPgBoundaries.constEnd(),
+                            oldFirstPosition,
+                            [](const QPair<int, int> &pgBoundary, int position) {
+                                return pgBoundary.first < position;
+                            });
+                    if (it != oldPgBoundaries.constEnd() && it->first == oldFirstPosition
+                        && oldPgBoundaries.constEnd() - it == pageCount - pageIndex) {
+                        for (auto it2 = it; it2 != oldPgBoundaries.constEnd(); ++it2)
+                            pgBoundaries << qMakePair(it2->first + dirtyRange.delta,
+                                                      it2->second + dirtyRange.delta);
+                        pgBoundaries.last().second = endCursorPosition;
+                        break;
                     }
                 }
+
+                const int lastPosition = pageIndex == pageCount - 1
+                        ? endCursorPosition
+                        : layout->hitTest(contentsRect.bottomRight(), Qt::FuzzyHit);
+                pgBoundaries << qMakePair(firstPosition,
+                                          lastPosition >= 0 ? lastPosition : endCursorPosition);
+
+                ++pageIndex;
+            }
+        }
+
+        if (pageCount > 0) {
+            ScreenplayElement *lastElement =
+                    m_screenplay->elementAt(m_screenplay->elementCount() - 1);
+            if (lastElement == nullptr)
+                fpageCount = 0.01;
+            else {
+                QTextFrame *lastFrame = this->findTextFrame(lastElement);
+                if (lastFrame == nullptr)
+                    fpageCount = pageCount;
+                else {
+                    const QRectF contentsRect =
+                            pageContentsRect(paperRect, pageMargins, pageCount - 1);
+                    const QRectF lastFrameRect = layout->frameBoundingRect(lastFrame);
+                    fpageCount = pageCount - 1;
+                    fpageCount +=
+                            (lastFrameRect.bottom() - contentsRect.top()) / contentsRect.height();
+                }
             }
         }
 
         this->setPageCount(fpageCount);
+
+        dirtyRange = PageBoundariesDirtyRange();
+        dirtyRange.all = false;
     }
 
     m_pageBoundaries = pgBoundaries;
@@ -2275,6 +2342,335 @@ void ScreenplayTextDocument::evaluatePageBoundariesLater()
     m_pageBoundaryEvalTimer.start(500, this);
 }
 
+void ScreenplayTextDocument::connectToTextDocumentSignals()
+{
+    m_pageBoundariesDirtyRange.all = true;
+
+    if (m_textDocument != nullptr)
+        connect(m_textDocument, &QTextDocument::contentsChange, this,
+                &ScreenplayTextDocument::onTextDocumentContentsChange, Qt::UniqueConnection);
+}
+
+void ScreenplayTextDocument::onTextDocumentContentsChange(int position, int charsRemoved,
+                                                          int charsAdded)
+{
+    if (this->sender() != m_textDocument)
+        return;
+
+    // Edits are accumulated into a single range in the current document, so that
+    // evaluatePageBoundaries() knows where to start and when it can stop.
+    PageBoundariesDirtyRange &dirtyRange = m_pageBoundariesDirtyRange;
+    if (dirtyRange.all)
+        return;
+
+    if (dirtyRange.from < 0) {
+        dirtyRange.from = position;
+        dirtyRange.to = position + charsAdded;
+    } else {
+        dirtyRange.from = qMin(dirtyRange.from, position);
+        dirtyRange.to = dirtyRange.to >= position + charsRemoved
+                ? dirtyRange.to + charsAdded - charsRemoved
+                : position + charsAdded;
+    }
+
+    dirtyRange.delta += charsAdded - charsRemoved;
+}
+
+struct ScreenplayTextDocument_LayoutTaskItem
+{
+    // Scenes get a frame of their own, while breaks are blocks in the root frame.
+    const ScreenplayElement *element = nullptr;
+    bool isFrame = false;
+    QTextFrameFormat frameFormat;
+    QVector<ScreenplayTextBlockContent> blocks;
+};
+
+struct ScreenplayTextDocument_LayoutTaskSnapshot
+{
+    int generation = 0;
+    QFont defaultFont;
+    QSizeF pageSize;
+    QRectF paperRect;
+    QMarginsF pageMargins;
+    QTextFrameFormat rootFrameFormat;
+    const ScreenplayElement *lastElement = nullptr;
+    QVector<ScreenplayTextDocument_LayoutTaskItem> items;
+};
+
+struct ScreenplayTextDocument_LayoutTaskResult
+{
+    int generation = -1;
+    qreal pageCount = 0;
+    int documentLength = 0;
+    QList<QPair<int, int>> pageBoundaries;
+    QHash<const ScreenplayElement *, ScreenplayTextFrameLayout> frameLayouts;
+};
+Q_DECLARE_METATYPE(ScreenplayTextDocument_LayoutTaskResult)
+
+/**
+ * Runs in a background thread. Only the snapshot is read here, screenplay elements in it
+ * are used as keys and never dereferenced.
+ */
+ScreenplayTextDocument_LayoutTaskResult
+ScreenplayTextDocument_LayoutTask(const ScreenplayTextDocument_LayoutTaskSnapshot &snapshot)
+{
+    ScreenplayTextDocument_LayoutTaskResult result;
+    result.generation = snapshot.generation;
+
+    QTextDocument document;
+    document.setUndoRedoEnabled(false);
+    document.setDefaultFont(snapshot.defaultFont);
+    document.setUseDesignMetrics(true);
+    document.setPageSize(snapshot.pageSize);
+    document.setIndentWidth(10);
+    document.rootFrame()->setFrameFormat(snapshot.rootFrameFormat);
+
+    QTextBlockFormat frameBoundaryBlockFormat;
+    frameBoundaryBlockFormat.setLineHeight(0, QTextBlockFormat::FixedHeight);
+
+    QVector<QPair<const ScreenplayElement *, QTextFrame *>> frames;
+    frames.reserve(snapshot.items.size());
+
+    QTextCursor cursor(&document);
+    for (const ScreenplayTextDocument_LayoutTaskItem &item : snapshot.items) {
+        if (!item.isFrame) {
+            for (const ScreenplayTextBlockContent &block : item.blocks) {
+                cursor.insertBlock();
+                cursor.setBlockFormat(block.blockFormat);
+                cursor.setCharFormat(block.charFormat);
+                cursor.insertText(block.text);
+            }
+            continue;
+        }
+
+        QTextFrame *frame = cursor.insertFrame(item.frameFormat);
+        for (int i = 0; i < item.blocks.size(); i++) {
+            const ScreenplayTextBlockContent &block = item.blocks.at(i);
+            if (i > 0)
+                cursor.insertBlock();
+            cursor.setCharFormat(block.charFormat);
+            cursor.setBlockFormat(block.blockFormat);
+            cursor.insertText(block.text);
+        }
+        frames.append(qMakePair(item.element, frame));
+
+        cursor = document.rootFrame()->lastCursorPosition();
+        cursor.setBlockFormat(frameBoundaryBlockFormat);
+    }
+
+    QAbstractTextDocumentLayout *layout = document.documentLayout();
+
+    const int pageCount = document.pageCount();
+    const int endCursorPosition = document.characterCount() - 1;
+    for (int pageIndex = 0; pageIndex < pageCount; pageIndex++) {
+        const QRectF contentsRect =
+                pageContentsRect(snapshot.paperRect, snapshot.pageMargins, pageIndex);
+        const int firstPosition = result.pageBoundaries.isEmpty()
+                ? layout->hitTest(contentsRect.topLeft(), Qt::FuzzyHit)
+                : result.pageBoundaries.last().second + 1;
+        const int lastPosition = pageIndex == pageCount - 1
+                ? endCursorPosition
+                : layout->hitTest(contentsRect.bottomRight(), Qt::FuzzyHit);
+        result.pageBoundaries << qMakePair(firstPosition,
+                                           lastPosition >= 0 ? lastPosition : endCursorPosition);
+    }
+
+    QRectF lastFrameRect;
+    for (const QPair<const ScreenplayElement *, QTextFrame *> &item : qAsConst(frames)) {
+        const QTextFrame *frame = item.second;
+        const QRectF frameRect = layout->frameBoundingRect(const_cast<QTextFrame *>(frame));
+
+        // Every scene frame begins with its heading.
+        ScreenplayTextFrameLayout frameLayout;
+        frameLayout.firstPosition = frame->firstPosition();
+        frameLayout.paragraphPosition = frame->firstCursorPosition().block().next().position();
+        frameLayout.lastPosition = frame->lastPosition();
+        frameLayout.height = frameRect.height();
+        result.frameLayouts.insert(item.first, frameLayout);
+
+        if (item.first == snapshot.lastElement)
+            lastFrameRect = frameRect;
+    }
+
+    result.documentLength = endCursorPosition;
+    result.pageCount = 0.1;
+    if (pageCount > 0) {
+        if (snapshot.lastElement == nullptr)
+            result.pageCount = 0.01;
+        else if (lastFrameRect.isNull())
+            result.pageCount = pageCount;
+        else {
+            const QRectF contentsRect =
+                    pageContentsRect(snapshot.paperRect, snapshot.pageMargins, pageCount - 1);
+            result.pageCount = pageCount - 1;
+            result.pageCount +=
+                    (lastFrameRect.bottom() - contentsRect.top()) / contentsRect.height();
+        }
+    }
+
+    return result;
+}
+
+bool ScreenplayTextDocument::canLayoutInBackground() const
+{
+    // The background layout shapes text on a worker thread, which not all platforms support.
+    return m_layoutInBackground && m_purpose == ForDisplay && m_syncEnabled && !m_titlePage
+            && !m_listSceneCharacters && !m_includeSceneSynopsis && !m_includeSceneFeaturedImage
+            && !m_includeSceneComments && m_injection.isNull()
+            && QFontDatabase::supportsThreadedFontRendering();
+}
+
+void ScreenplayTextDocument::layoutInBackground()
+{
+    typedef QFutureWatcher<ScreenplayTextDocument_LayoutTaskResult> LayoutTaskWatcher;
+
+    const QString watcherName = QStringLiteral("BackgroundLayoutFutureWatcher");
+    if (this->findChild<LayoutTaskWatcher *>(watcherName, Qt::FindDirectChildrenOnly)) {
+        // Only one layout runs at any time. Another snapshot is taken once it is done.
+        m_backgroundLayoutTimer.start(250, this);
+        return;
+    }
+
+    if (!this->canLayoutInBackground())
+        return;
+
+    if (m_screenplay == nullptr || m_formatting == nullptr || m_textDocument == nullptr) {
+        m_backgroundFrameLayouts.clear();
+        m_backgroundLayoutDocumentLength = 0;
+        m_pageBoundaries.clear();
+        emit pageBoundariesChanged();
+        return;
+    }
+
+    // The text document remains empty, but it is configured nevertheless because
+    // lengthInPages() picks up page metrics from it.
+    if (m_textDocument->defaultFont() != m_formatting->defaultFont())
+        m_textDocument->setDefaultFont(m_formatting->defaultFont());
+    m_formatting->pageLayout()->configure(m_textDocument);
+
+    ScreenplayTextDocument_LayoutTaskSnapshot snapshot;
+    snapshot.generation = m_backgroundLayoutGeneration;
+    snapshot.defaultFont = m_textDocument->defaultFont();
+    snapshot.pageSize = m_textDocument->pageSize();
+    snapshot.paperRect = m_formatting->pageLayout()->paperRect();
+    snapshot.pageMargins = m_formatting->pageLayout()->margins();
+    snapshot.rootFrameFormat = m_textDocument->rootFrame()->frameFormat();
+    snapshot.lastElement = m_screenplay->elementAt(m_screenplay->elementCount() - 1);
+    snapshot.items.reserve(m_screenplay->elementCount());
+
+    // What follows captures whatever loadScreenplay() and loadScreenplayElement() would have
+    // placed in a display document, which affects its layout.
+    const bool hasEpisodes = this->screenplayHasEpisodes();
+    const ScreenplayElement *lastPrintedElement = nullptr;
+
+    auto createBreakItem = [&](const ScreenplayElement *element, bool addPageBreak) {
+        ScreenplayTextDocument_LayoutTaskItem item;
+        item.element = element;
+        item.blocks.append(
+                this->breakBlock(element, addPageBreak, hasEpisodes, lastPrintedElement));
+        return item;
+    };
+
+    for (int i = 0; i < m_screenplay->elementCount(); i++) {
+        const ScreenplayElement *element = m_screenplay->elementAt(i);
+        const bool isBreak = element->elementType() == ScreenplayElement::BreakElementType;
+
+        if (!m_printEachSceneOnANewPage) {
+            if (hasEpisodes && isBreak && element->breakType() == Screenplay::Episode) {
+                snapshot.items.append(createBreakItem(element, i > 0));
+                lastPrintedElement = element;
+                continue;
+            }
+
+            if (m_printEachActOnANewPage && isBreak && element->breakType() == Screenplay::Act) {
+                snapshot.items.append(createBreakItem(element, i > 0));
+                lastPrintedElement = element;
+                continue;
+            }
+        }
+
+        if (m_includeActBreaks && isBreak && element->breakType() == Screenplay::Act
+            && lastPrintedElement != element) {
+            snapshot.items.append(createBreakItem(element, false));
+            lastPrintedElement = element;
+            continue;
+        }
+
+        if (element->elementType() != ScreenplayElement::SceneElementType)
+            continue;
+
+        ScreenplayTextDocument_LayoutTaskItem item;
+        item.element = element;
+        item.isFrame = true;
+        item.frameFormat = this->sceneFrameFormat(element, i, lastPrintedElement);
+
+        Scene *scene = element->scene();
+        if (scene != nullptr) {
+            this->connectToSceneSignals(scene);
+
+            item.blocks.append(this->paragraphBlock(SceneElement::Heading, Qt::Alignment(), true,
+                                                    this->displaySceneHeadingText(element)));
+
+            if (!element->isOmitted()) {
+                item.blocks.reserve(scene->elementCount() + 1);
+                for (int j = 0; j < scene->elementCount(); j++) {
+                    const SceneElement *para = scene->elementAt(j);
+                    item.blocks.append(this->paragraphBlock(para->type(), para->alignment(), false,
+                                                            para->text()));
+                }
+            }
+        }
+
+        snapshot.items.append(item);
+        lastPrintedElement = element;
+    }
+
+    // Since the result travels from background thread to main thread
+    static int taskResultTypeId = qRegisterMetaType<ScreenplayTextDocument_LayoutTaskResult>();
+    Q_UNUSED(taskResultTypeId)
+
+    LayoutTaskWatcher *watcher = new LayoutTaskWatcher(this);
+    watcher->setObjectName(watcherName);
+    connect(watcher, &LayoutTaskWatcher::finished, this, [=]() {
+        const ScreenplayTextDocument_LayoutTaskResult result = watcher->result();
+
+        // Results laid out from snapshots taken before the latest change are of no use.
+        if (result.generation != m_backgroundLayoutGeneration || !this->canLayoutInBackground())
+            return;
+
+        m_backgroundFrameLayouts = result.frameLayouts;
+        m_backgroundLayoutDocumentLength = result.documentLength;
+        m_pageBoundaries = result.pageBoundaries;
+        this->setPageCount(result.pageCount);
+        emit pageBoundariesChanged();
+
+        this->evaluateCurrentPageAndPosition();
+        emit updateFinished();
+    });
+    connect(watcher, &LayoutTaskWatcher::finished, watcher, &QObject::deleteLater);
+
+    watcher->setFuture(QtConcurrent::run(ScreenplayTextDocument_LayoutTask, snapshot));
+}
+
+void ScreenplayTextDocument::layoutInBackgroundLater()
+{
+    // Layouts already running in the background are stale from now on.
+    ++m_backgroundLayoutGeneration;
+    m_backgroundLayoutTimer.start(250, this);
+}
+
+bool ScreenplayTextDocument::screenplayHasEpisodes() const
+{
+    if (m_screenplay->scriteDocument() != nullptr)
+        return m_screenplay->episodeCount() > 0;
+
+    const QList<ScreenplayElement *> allElements = m_screenplay->getElements();
+    return std::any_of(allElements.begin(), allElements.end(), [](ScreenplayElement *e) {
+        return e->elementType() == ScreenplayElement::BreakElementType
+                && e->breakType() == Screenplay::Episode;
+    });
+}
+
 void ScreenplayTextDocument::formatAllBlocks()
 {
     if (m_screenplay == nullptr || m_formatting == nullptr || m_updating || !m_componentComplete
@@ -2454,14 +2850,10 @@ void ScreenplayTextDocument::loadScreenplayElement(const ScreenplayElement *elem
 
         auto prepareCursor = [=](QTextCursor &cursor, SceneElement::Type paraType,
                                  Qt::Alignment overrideAlignment, bool firstParagraph) {
-            const qreal pageWidth = m_formatting->pageLayout()->contentWidth();
-            const SceneElementFormat *format = m_formatting->elementFormat(paraType);
-            QTextBlockFormat blockFormat = format->createBlockFormat(overrideAlignment, &pageWidth);
-            QTextCharFormat charFormat = format->createCharFormat(&pageWidth);
-            if (firstParagraph)
-                blockFormat.setTopMargin(0);
-            cursor.setCharFormat(charFormat);
-            cursor.setBlockFormat(blockFormat);
+            const ScreenplayTextBlockContent block =
+                    this->paragraphBlock(paraType, overrideAlignment, firstParagraph);
+            cursor.setCharFormat(block.charFormat);
+            cursor.setBlockFormat(block.blockFormat);
         };
 
         const SceneHeading *heading = scene->heading();
@@ -2511,49 +2903,29 @@ void ScreenplayTextDocument::loadScreenplayElement(const ScreenplayElement *elem
                 }
             }
 
-            if (element->isOmitted()) {
-                if (m_purpose == ForDisplay && heading->isEnabled() && m_sceneNumbers)
-                    cursor.insertText(element->resolvedSceneNumber() + QStringLiteral(". "));
-
+            // Headings are always shown in display documents.
+            if (m_purpose == ForDisplay) {
+                cursor.insertText(this->displaySceneHeadingText(element));
+                insertBlock = true;
+            } else if (element->isOmitted()) {
                 cursor.insertText(QStringLiteral("[OMITTED] "));
-
                 insertBlock = true;
             }
         }
 
-        if (!element->isOmitted()) {
-            if (m_purpose == ForPrinting) {
-                if (heading->isEnabled()) {
-                    TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor,
-                                                                           heading->locationType());
-                    cursor.insertText(QStringLiteral(". "));
-                    TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor,
-                                                                           heading->location());
-                    cursor.insertText(QStringLiteral(" - "));
-                    TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor,
-                                                                           heading->moment());
-
-                    insertBlock = true;
-                } /*else {
-                    cursor.insertText(QStringLiteral("NO SCENE HEADING"));
-                }*/
-            } else {
-                if (heading->isEnabled()) {
-                    if (m_sceneNumbers)
-                        cursor.insertText(element->resolvedSceneNumber() + QStringLiteral(". "));
-                    cursor.insertText(heading->locationType());
-                    cursor.insertText(QStringLiteral(". "));
-                    cursor.insertText(heading->location());
-                    cursor.insertText(QStringLiteral(" - "));
-                    cursor.insertText(heading->moment());
-
-                    insertBlock = true;
-                } else {
-                    cursor.insertText(QStringLiteral("NO SCENE HEADING"));
+        if (!element->isOmitted() && m_purpose == ForPrinting) {
+            if (heading->isEnabled()) {
+                TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor,
+                                                                       heading->locationType());
+                cursor.insertText(QStringLiteral(". "));
+                TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor, heading->location());
+                cursor.insertText(QStringLiteral(" - "));
+                TransliterationUtils::polishFontsAndInsertTextAtCursor(cursor, heading->moment());
 
-                    insertBlock = true;
-                }
-            }
+                insertBlock = true;
+            } /*else {
+                cursor.insertText(QStringLiteral("NO SCENE HEADING"));
+            }*/
         }
 
         if (element->isOmitted())
@@ -2829,6 +3201,102 @@ void ScreenplayTextDocument::loadScreenplayElement(const ScreenplayElement *elem
     }
 }
 
+ScreenplayTextBlockContent ScreenplayTextDocument::paragraphBlock(SceneElement::Type paraType,
+                                                                  Qt::Alignment overrideAlignment,
+                                                                  bool firstParagraph,
+                                                                  const QString &text) const
+{
+    const qreal pageWidth = m_formatting->pageLayout()->contentWidth();
+    const SceneElementFormat *format = m_formatting->elementFormat(paraType);
+
+    ScreenplayTextBlockContent block;
+    block.blockFormat = format->createBlockFormat(overrideAlignment, &pageWidth);
+    block.charFormat = format->createCharFormat(&pageWidth);
+    block.text = text;
+    if (firstParagraph)
+        block.blockFormat.setTopMargin(0);
+    return block;
+}
+
+ScreenplayTextBlockContent
+ScreenplayTextDocument::breakBlock(const ScreenplayElement *element, bool addPageBreak,
+                                   bool hasEpisodes,
+                                   const ScreenplayElement *lastPrintedElement) const
+{
+    const bool episode = element->breakType() == Screenplay::Episode;
+
+    ScreenplayTextBlockContent block;
+    if (addPageBreak)
+        block.blockFormat.setPageBreakPolicy(QTextBlockFormat::PageBreak_AlwaysBefore);
+    else if (!episode)
+        block.blockFormat.setTopMargin(
+                this->paragraphBlock(SceneElement::Heading, Qt::Alignment(), false)
+                        .blockFormat.topMargin());
+
+    block.charFormat.setFontPointSize(m_textDocument->defaultFont().pointSize()
+                                      + (episode ? 2 : 0));
+    block.charFormat.setFontWeight(QFont::ExtraBold);
+
+    if (episode)
+        block.text = element->breakTitle().toUpper();
+    else {
+        if (hasEpisodes
+            && (!lastPrintedElement
+                || lastPrintedElement->elementType() != ScreenplayElement::BreakElementType))
+            block.text = QStringLiteral("Episode ") + QString::number(element->episodeIndex() + 1)
+                    + QStringLiteral(", ");
+        block.text += element->breakTitle();
+    }
+
+    if (!element->breakSubtitle().isEmpty())
+        block.text += QStringLiteral(": ") + element->breakSubtitle().toUpper();
+
+    return block;
+}
+
+QTextFrameFormat
+ScreenplayTextDocument::sceneFrameFormat(const ScreenplayElement *element, int index,
+                                         const ScreenplayElement *lastPrintedElement) const
+{
+    QTextFrameFormat frameFormat = m_sceneFrameFormat;
+
+    const Scene *scene = element->scene();
+    if (scene != nullptr
+        && (index > m_screenplay->firstSceneIndex() || element != lastPrintedElement)) {
+        SceneElement::Type firstParaType = SceneElement::Heading;
+        if (!scene->heading()->isEnabled() && scene->elementCount())
+            firstParaType = scene->elementAt(0)->type();
+
+        frameFormat.setTopMargin(this->paragraphBlock(firstParaType, Qt::Alignment(), false)
+                                         .blockFormat.topMargin());
+    }
+
+    if (index > 0 && m_printEachSceneOnANewPage)
+        frameFormat.setPageBreakPolicy(QTextFrameFormat::PageBreak_AlwaysBefore);
+
+    return frameFormat;
+}
+
+QString ScreenplayTextDocument::displaySceneHeadingText(const ScreenplayElement *element) const
+{
+    const SceneHeading *heading = element->scene()->heading();
+
+    QString ret;
+    if (element->isOmitted()) {
+        if (heading->isEnabled() && m_sceneNumbers)
+            ret = element->resolvedSceneNumber() + QStringLiteral(". ");
+        ret += QStringLiteral("[OMITTED] ");
+    } else if (heading->isEnabled()) {
+        if (m_sceneNumbers)
+            ret = element->resolvedSceneNumber() + QStringLiteral(". ");
+        ret += heading->locationType() + QStringLiteral(". ") + heading->location()
+                + QStringLiteral(" - ") + heading->moment();
+    } else
+        ret = QStringLiteral("NO SCENE HEADING");
+
+    return ret;
+}
+
 void ScreenplayTextDocument::formatBlock(const QTextBlock &block, const QString &text)
 {
     if (m_formatting == nullptr)
@@ -2886,6 +3354,34 @@ QTextFrame *ScreenplayTextDocument::findTextFrame(const ScreenplayElement *eleme
     return nullptr;
 }
 
+bool ScreenplayTextDocument::findFrameLayout(const ScreenplayElement *element,
+                                             ScreenplayTextFrameLayout &frameLayout) const
+{
+    if (this->canLayoutInBackground()) {
+        auto it = m_backgroundFrameLayouts.constFind(element);
+        if (it == m_backgroundFrameLayouts.constEnd())
+            return false;
+
+        frameLayout = it.value();
+        return true;
+    }
+
+    QTextFrame *frame = this->findTextFrame(element);
+    if (frame == nullptr)
+        return false;
+
+    QTextBlock block = frame->firstCursorPosition().block();
+    ScreenplayParagraphBlockData *blockData = ScreenplayParagraphBlockData::get(block);
+    if (blockData && blockData->elementType() == SceneElement::Heading)
+        block = block.next();
+
+    // Height is left out, because it makes the layout catch up till this frame.
+    frameLayout.firstPosition = frame->firstPosition();
+    frameLayout.paragraphPosition = block.position();
+    frameLayout.lastPosition = frame->lastPosition();
+    return true;
+}
+
 void ScreenplayTextDocument::onTextFrameDestroyed(QObject *object)
 {
     const ScreenplayElement *element = m_frameElementMap.value(object, nullptr);
@@ -64,6 +64,21 @@ class QQmlEngine;
 class ScreenplayTextDocumentUpdate;
 class SceneElementBlockTextUpdater;
 
+struct ScreenplayTextFrameLayout
+{
+    int firstPosition = 0; // where the scene heading begins
+    int paragraphPosition = 0; // where the first paragraph after scene heading begins
+    int lastPosition = 0;
+    qreal height = 0;
+};
+
+struct ScreenplayTextBlockContent
+{
+    QTextBlockFormat blockFormat;
+    QTextCharFormat charFormat;
+    QString text;
+};
+
 class ScreenplayTextDocument : public QObject, public QQmlParserStatus
 {
     Q_OBJECT
@@ -192,6 +207,17 @@ public:
     bool isIncludeMoreAndContdMarkers() const { return m_includeMoreAndContdMarkers; }
     Q_SIGNAL void includeMoreAndContdMarkersChanged();
 
+    // When set, page count, page boundaries and page breaks are evaluated by laying out a
+    // snapshot of the screenplay in a background thread, and textDocument is left empty.
+    // This is honoured only for documents meant for display, without title page, scene
+    // characters, synopsis, featured images, comments or injection. Others are always laid
+    // out in the calling thread.
+    Q_PROPERTY(bool layoutInBackground READ isLayoutInBackground WRITE setLayoutInBackground
+                       NOTIFY layoutInBackgroundChanged)
+    void setLayoutInBackground(bool val);
+    bool isLayoutInBackground() const { return m_layoutInBackground; }
+    Q_SIGNAL void layoutInBackgroundChanged();
+
     Q_PROPERTY(bool updating READ isUpdating NOTIFY updatingChanged)
     bool isUpdating() const { return m_updating; }
     Q_SIGNAL void updatingChanged();
@@ -331,9 +357,29 @@ private:
     void evaluateCurrentPageAndPosition();
     void evaluatePageBoundaries(bool revalCurrentPageAndPosition = true);
     void evaluatePageBoundariesLater();
+    void connectToTextDocumentSignals();
+    void onTextDocumentContentsChange(int position, int charsRemoved, int charsAdded);
+    bool canLayoutInBackground() const;
+    void layoutInBackground();
+    void layoutInBackgroundLater();
+    bool screenplayHasEpisodes() const;
+    bool findFrameLayout(const ScreenplayElement *element,
+                         ScreenplayTextFrameLayout &frameLayout) const;
     void formatAllBlocks();
     bool updateFromScreenplayElement(const ScreenplayElement *element);
     void loadScreenplayElement(const ScreenplayElement *element, QTextCursor &cursor);
+
+    // Used both while loading the text document and while laying it out in the background,
+    // so that both arrive at the same layout.
+    ScreenplayTextBlockContent paragraphBlock(SceneElement::Type paraType,
+                                              Qt::Alignment overrideAlignment, bool firstParagraph,
+                                              const QString &text = QString()) const;
+    ScreenplayTextBlockContent breakBlock(const ScreenplayElement *element, bool addPageBreak,
+                                          bool hasEpisodes,
+                                          const ScreenplayElement *lastPrintedElement) const;
+    QTextFrameFormat sceneFrameFormat(const ScreenplayElement *element, int index,
+                                      const ScreenplayElement *lastPrintedElement) const;
+    QString displaySceneHeadingText(const ScreenplayElement *element) const;
     void formatBlock(const QTextBlock &block, const QString &text = QString());
 
     void removeTextFrame(const ScreenplayElement *element);
@@ -381,12 +427,24 @@ private:
     ExecLaterTimer m_loadScreenplayTimer;
     QStringList m_highlightDialoguesOf;
     ExecLaterTimer m_pageBoundaryEvalTimer;
+    bool m_layoutInBackground = false;
+    int m_backgroundLayoutGeneration = 0;
+    ExecLaterTimer m_backgroundLayoutTimer;
+    int m_backgroundLayoutDocumentLength = 0;
+    QHash<const ScreenplayElement *, ScreenplayTextFrameLayout> m_backgroundFrameLayouts;
     QTextFrameFormat m_sceneFrameFormat;
     QObjectProperty<QObject> m_injection;
     bool m_connectedToScreenplaySignals = false;
     bool m_connectedToFormattingSignals = false;
     QPagedPaintDevice::PageSize m_paperSize = QPagedPaintDevice::Letter;
     QList<QPair<int, int>> m_pageBoundaries;
+    struct PageBoundariesDirtyRange
+    {
+        bool all = true; // page boundaries must be evaluated from scratch
+        int from = -1; // first position edited, or -1 if nothing was edited
+        int to = -1; // last position edited, in the current document
+        int delta = 0; // net number of characters added
+    } m_pageBoundariesDirtyRange;
     QObjectProperty<Screenplay> m_screenplay;
     friend class ScreenplayTextDocumentUpdate;
     QObjectProperty<QTextDocument> m_textDocument;
@@ -242,14 +242,13 @@ void ScriteDocumentBackups::loadMetaData(int row)
             [](const QString &fileName) -> MetaData {
                 MetaData ret;
 
-                DocumentFileSystem dfs;
-                if (!dfs.load(fileName)) {
+                const QByteArray header = DocumentFileSystem::peekHeader(fileName);
+                if (header.isEmpty()) {
                     ret.loaded = true;
                     return ret;
                 }
 
-                const QJsonDocument jsonDoc = QJsonDocument::fromJson(dfs.header());
-                const QJsonObject docObj = jsonDoc.object();
+                const QJsonObject docObj = DocumentFileSystem::decodeHeader(header);
 
                 const QJsonObject structure = docObj.value(QStringLiteral("structure")).toObject();
                 ret.structureElementCount =
@@ -1413,8 +1412,17 @@ void ScriteDocument::saveAs(const QString &givenFileName)
 
     emit aboutToSave();
 
+    // Binary headers are compact and quick to parse, but older versions of Scrite
+    // cannot open them. So they are written only when explicitly asked for.
+    const bool binaryHeader =
+            Application::instance()->settings()->value(QStringLiteral("Document/binaryHeader"))
+                    .toBool();
+
     const QJsonObject json = QObjectSerializer::toJson(this);
-    const QByteArray bytes = QJsonDocument(json).toJson();
+    const QByteArray bytes = DocumentFileSystem::encodeHeader(
+            json,
+            binaryHeader ? DocumentFileSystem::BinaryHeaderEncoding
+                         : DocumentFileSystem::JsonHeaderEncoding);
     m_docFileSystem.setHeader(bytes);
 
 #ifndef QT_NO_DEBUG_OUTPUT
@@ -1427,7 +1435,7 @@ void ScriteDocument::saveAs(const QString &givenFileName)
         const QString fileName2 = fi.absolutePath() + "/" + fi.completeBaseName() + ".json";
         QFile file2(fileName2);
         file2.open(QFile::WriteOnly);
-        file2.write(bytes);
+        file2.write(binaryHeader ? QJsonDocument(json).toJson() : bytes);
     }
 
     if (m_autoSaveMode) {
@@ -2276,9 +2284,9 @@ bool ScriteDocument::load(const QString &fileName)
         return false;
     }
 
-    const QJsonDocument jsonDoc = format == DocumentFileSystem::ZipFormat
-            ? QJsonDocument::fromJson(m_docFileSystem.header())
-            : QJsonDocument::fromBinaryData(m_docFileSystem.header());
+    const QJsonObject json = format == DocumentFileSystem::ZipFormat
+            ? DocumentFileSystem::decodeHeader(m_docFileSystem.header())
+            : QJsonDocument::fromBinaryData(m_docFileSystem.header()).object();
 
 #ifndef QT_NO_DEBUG_OUTPUT
     {
@@ -2286,11 +2294,10 @@ bool ScriteDocument::load(const QString &fileName)
         const QString fileName2 = fi.absolutePath() + "/" + fi.completeBaseName() + ".json";
         QFile file2(fileName2);
         file2.open(QFile::WriteOnly);
-        file2.write(jsonDoc.toJson());
+        file2.write(QJsonDocument(json).toJson());
     }
 #endif
 
-    const QJsonObject json = jsonDoc.object();
     if (json.isEmpty()) {
         m_errorReport->setErrorMessage(QStringLiteral("%1 is not a Scrite document.").arg(fileName),
                                        details);
@@ -18,7 +18,6 @@
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonObject>
-#include <QJsonDocument>
 
 bool ScriteFileInfo::isValid() const
 {
@@ -61,12 +60,13 @@ ScriteFileInfo ScriteFileInfo::load(const QFileInfo &fileInfo)
         && !fileInfo.isReadable())
         return ret;
 
-    DocumentFileSystem dfs;
-    if (!dfs.load(fileInfo.absoluteFilePath()))
+    // Only the header and cover page are needed here, so we avoid extracting
+    // the whole document (with all its attachments) into a temporary folder.
+    const QByteArray header = DocumentFileSystem::peekHeader(fileInfo.absoluteFilePath());
+    if (header.isEmpty())
         return ret;
 
-    const QJsonDocument jsonDoc = QJsonDocument::fromJson(dfs.header());
-    const QJsonObject docObj = jsonDoc.object();
+    const QJsonObject docObj = DocumentFileSystem::decodeHeader(header);
     const QJsonObject screenplayObj = docObj.value("screenplay").toObject();
     const QJsonArray screenplayElementsArr = screenplayObj.value("elements").toArray();
 
@@ -88,10 +88,13 @@ ScriteFileInfo ScriteFileInfo::load(const QFileInfo &fileInfo)
                                                == QStringLiteral("SceneElementType");
                                    });
 
-    const QString coverPagePath = dfs.absolutePath(Screenplay::standardCoverPathPhotoPath());
-    ret.coverPageImage = QFile::exists(coverPagePath)
-            ? QImage(coverPagePath).scaled(512, 512, Qt::KeepAspectRatio, Qt::SmoothTransformation)
-            : QImage();
+    const QByteArray coverPageBytes = DocumentFileSystem::peekFile(
+            fileInfo.absoluteFilePath(), Screenplay::standardCoverPathPhotoPath());
+    const QImage coverPageImage =
+            coverPageBytes.isEmpty() ? QImage() : QImage::fromData(coverPageBytes);
+    ret.coverPageImage = coverPageImage.isNull()
+            ? QImage()
+            : coverPageImage.scaled(512, 512, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     ret.hasCoverPage = !ret.coverPageImage.isNull();
 
     return ret;
@@ -5558,6 +5558,11 @@ void StructureCanvasViewportFilterModel::setEnabled(bool val)
     emit enabledChanged();
 
     this->invalidateSelfLater();
+    if (!m_enabled) {
+        // All rows are accepted while disabled, and invalidateSelf() is not scheduled.
+        m_visibleObjects.clear();
+        this->invalidateFilter();
+    }
 }
 
 void StructureCanvasViewportFilterModel::setType(StructureCanvasViewportFilterModel::Type val)
@@ -5590,6 +5595,8 @@ void StructureCanvasViewportFilterModel::setComputeStrategy(
 
     m_computeStrategy = val;
     emit computeStrategyChanged();
+
+    this->invalidateSelfLater();
 }
 
 void StructureCanvasViewportFilterModel::setFilterStrategy(
@@ -5628,18 +5635,20 @@ void StructureCanvasViewportFilterModel::setSourceModel(QAbstractItemModel *mode
 {
     QAbstractItemModel *oldModel = this->sourceModel();
     if (oldModel != nullptr) {
-        connect(oldModel, &QAbstractItemModel::rowsInserted, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
-        connect(oldModel, &QAbstractItemModel::rowsRemoved, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
-        connect(oldModel, &QAbstractItemModel::rowsMoved, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
-        connect(oldModel, &QAbstractItemModel::dataChanged, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
-        connect(oldModel, &QAbstractItemModel::modelReset, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
+        disconnect(oldModel, &QAbstractItemModel::rowsInserted, this,
+                   &StructureCanvasViewportFilterModel::onSourceRowsInserted);
+        disconnect(oldModel, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                   &StructureCanvasViewportFilterModel::onSourceRowsAboutToBeRemoved);
+        disconnect(oldModel, &QAbstractItemModel::rowsRemoved, this,
+                   &StructureCanvasViewportFilterModel::invalidateSelfLater);
+        disconnect(oldModel, &QAbstractItemModel::dataChanged, this,
+                   &StructureCanvasViewportFilterModel::onSourceDataChanged);
+        disconnect(oldModel, &QAbstractItemModel::modelReset, this,
+                   &StructureCanvasViewportFilterModel::onSourceModelReset);
     }
 
+    this->clearIndex();
+
     if (m_structure.isNull())
         this->QSortFilterProxyModel::setSourceModel(nullptr);
     else {
@@ -5651,18 +5660,21 @@ void StructureCanvasViewportFilterModel::setSourceModel(QAbstractItemModel *mode
             this->QSortFilterProxyModel::setSourceModel(nullptr);
     }
 
+    model = this->sourceModel();
     if (model != nullptr) {
         connect(model, &QAbstractItemModel::rowsInserted, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
+                &StructureCanvasViewportFilterModel::onSourceRowsInserted);
+        connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                &StructureCanvasViewportFilterModel::onSourceRowsAboutToBeRemoved);
         connect(model, &QAbstractItemModel::rowsRemoved, this,
                 &StructureCanvasViewportFilterModel::invalidateSelfLater);
-        connect(model, &QAbstractItemModel::rowsMoved, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
         connect(model, &QAbstractItemModel::dataChanged, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
+                &StructureCanvasViewportFilterModel::onSourceDataChanged);
         connect(model, &QAbstractItemModel::modelReset, this,
-                &StructureCanvasViewportFilterModel::invalidateSelfLater);
+                &StructureCanvasViewportFilterModel::onSourceModelReset);
     }
+
+    this->invalidateSelfLater();
 }
 
 bool StructureCanvasViewportFilterModel::filterAcceptsRow(int source_row,
@@ -5678,22 +5690,10 @@ bool StructureCanvasViewportFilterModel::filterAcceptsRow(int source_row,
         return true;
 
     const QObject *object = model->objectAt(source_row);
-    if (m_computeStrategy == PreComputeStrategy) {
-        if (source_row < 0 || source_row >= m_visibleSourceRows.size()
-            || object != m_visibleSourceRows.at(source_row).first) {
-            (const_cast<StructureCanvasViewportFilterModel *>(this))->invalidateSelfLater();
-            return false;
-        }
-
-        return m_visibleSourceRows.at(source_row).second;
-    }
+    if (m_computeStrategy == PreComputeStrategy)
+        return m_visibleObjects.contains(object);
 
-    const QRectF objectRect = (m_type == AnnotationType)
-            ? (qobject_cast<const Annotation *>(object))->geometry()
-            : (qobject_cast<const StructureElement *>(object))->geometry();
-    if (m_filterStrategy == ContainsStrategy)
-        return m_viewportRect.contains(objectRect);
-    return m_viewportRect.intersects(objectRect);
+    return this->isObjectInViewport(this->objectGeometry(object));
 }
 
 void StructureCanvasViewportFilterModel::timerEvent(QTimerEvent *te)
@@ -5726,7 +5726,6 @@ void StructureCanvasViewportFilterModel::updateSourceModel()
 
 void StructureCanvasViewportFilterModel::invalidateSelf()
 {
-    m_visibleSourceRows.clear();
     const AbstractQObjectListModel *model = m_computeStrategy == OnDemandComputeStrategy
             ? nullptr
             : qobject_cast<AbstractQObjectListModel *>(this->sourceModel());
@@ -5735,30 +5734,249 @@ void StructureCanvasViewportFilterModel::invalidateSelf()
         return;
     }
 
-    m_visibleSourceRows.reserve(model->objectCount());
-    for (int i = 0; i < model->objectCount(); i++) {
-        const QObject *object = model->objectAt(i);
-
-        if (m_viewportRect.size().isEmpty())
-            m_visibleSourceRows << qMakePair(object, true);
-        else {
-            const QRectF objectRect = (m_type == AnnotationType)
-                    ? (qobject_cast<const Annotation *>(object))->geometry()
-                    : (qobject_cast<const StructureElement *>(object))->geometry();
-            if (m_filterStrategy == ContainsStrategy)
-                m_visibleSourceRows << qMakePair(object, m_viewportRect.contains(objectRect));
-            else
-                m_visibleSourceRows << qMakePair(object, m_viewportRect.intersects(objectRect));
-        }
+    if (!m_indexValid) {
+        this->clearIndex();
+        for (int i = 0; i < model->objectCount(); i++)
+            this->indexObject(model->objectAt(i));
+        m_indexValid = true;
     }
 
+    QSet<const QObject *> visibleObjects;
+    if (m_viewportRect.size().isEmpty()) {
+        visibleObjects.reserve(m_indexedObjects.size());
+        for (auto it = m_indexedObjects.constBegin(); it != m_indexedObjects.constEnd(); ++it)
+            visibleObjects.insert(it.key());
+    } else
+        visibleObjects = this->objectsInViewport();
+
+    // While panning, most viewport changes leave the same objects in view. Rows are
+    // filtered again only when objects enter or leave the viewport, in which case
+    // QSortFilterProxyModel inserts and removes just the rows whose state changed.
+    if (visibleObjects == m_visibleObjects)
+        return;
+
+    m_visibleObjects = visibleObjects;
     this->invalidateFilter();
 }
 
 void StructureCanvasViewportFilterModel::invalidateSelfLater()
 {
-    if (m_enabled && m_computeStrategy == PreComputeStrategy)
+    if (m_enabled)
         m_invalidateTimer.start(0, this);
     else
         m_invalidateTimer.stop();
 }
+
+void StructureCanvasViewportFilterModel::onSourceRowsInserted(const QModelIndex &parent,
+                                                              int first, int last)
+{
+    Q_UNUSED(parent)
+    const AbstractQObjectListModel *model =
+            qobject_cast<AbstractQObjectListModel *>(this->sourceModel());
+    if (model != nullptr && m_indexValid) {
+        for (int i = first; i <= last; i++)
+            this->indexObject(model->objectAt(i));
+    }
+
+    this->invalidateSelfLater();
+}
+
+void StructureCanvasViewportFilterModel::onSourceRowsAboutToBeRemoved(const QModelIndex &parent,
+                                                                      int first, int last)
+{
+    Q_UNUSED(parent)
+    const AbstractQObjectListModel *model =
+            qobject_cast<AbstractQObjectListModel *>(this->sourceModel());
+    if (model != nullptr && m_indexValid) {
+        for (int i = first; i <= last; i++) {
+            QObject *object = model->objectAt(i);
+            this->unindexObject(object);
+            m_visibleObjects.remove(object);
+        }
+    }
+}
+
+void StructureCanvasViewportFilterModel::onSourceDataChanged()
+{
+    // The pre-compute strategy picks up changes in geometry from the indexed objects
+    // themselves, so only the on-demand strategy has to evaluate all rows again.
+    if (m_computeStrategy == OnDemandComputeStrategy)
+        this->invalidateSelfLater();
+}
+
+void StructureCanvasViewportFilterModel::onSourceModelReset()
+{
+    m_indexValid = false;
+    this->invalidateSelfLater();
+}
+
+QRectF StructureCanvasViewportFilterModel::objectGeometry(const QObject *object) const
+{
+    if (m_type == AnnotationType) {
+        const Annotation *annotation = qobject_cast<const Annotation *>(object);
+        return annotation ? annotation->geometry() : QRectF();
+    }
+
+    const StructureElement *element = qobject_cast<const StructureElement *>(object);
+    return element ? element->geometry() : QRectF();
+}
+
+bool StructureCanvasViewportFilterModel::isObjectInViewport(const QRectF &objectRect) const
+{
+    if (m_filterStrategy == ContainsStrategy)
+        return m_viewportRect.contains(objectRect);
+    return m_viewportRect.intersects(objectRect);
+}
+
+/**
+ * Cells of the grid are large enough for an index card to span only a few of them, which
+ * keeps updates cheap when cards are dragged around, and small enough for a viewport query
+ * to not have to look at too many objects outside the viewport.
+ */
+static const qreal viewportGridCellSize = 512;
+
+static QRect viewportGridCells(const QRectF &rect)
+{
+    const int left = qFloor(rect.left() / viewportGridCellSize);
+    const int top = qFloor(rect.top() / viewportGridCellSize);
+    const int right = qFloor(rect.right() / viewportGridCellSize);
+    const int bottom = qFloor(rect.bottom() / viewportGridCellSize);
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+static quint64 viewportGridCellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint64(quint32(y));
+}
+
+void StructureCanvasViewportFilterModel::indexObject(QObject *object)
+{
+    if (object == nullptr || m_indexedObjects.contains(object))
+        return;
+
+    IndexedObject indexed;
+    indexed.rect = this->objectGeometry(object);
+    if (m_type == AnnotationType) {
+        Annotation *annotation = qobject_cast<Annotation *>(object);
+        if (annotation != nullptr)
+            indexed.connection = connect(annotation, &Annotation::geometryChanged, this,
+                                         [=]() { this->updateObjectGeometry(object); });
+    } else {
+        StructureElement *element = qobject_cast<StructureElement *>(object);
+        if (element != nullptr)
+            indexed.connection = connect(element, &StructureElement::geometryChanged, this,
+                                         [=]() { this->updateObjectGeometry(object); });
+    }
+
+    const QRect cells = viewportGridCells(indexed.rect);
+    for (int x = cells.left(); x <= cells.right(); x++)
+        for (int y = cells.top(); y <= cells.bottom(); y++)
+            m_grid[viewportGridCellKey(x, y)].insert(object);
+
+    m_indexedObjects.insert(object, indexed);
+}
+
+void StructureCanvasViewportFilterModel::unindexObject(QObject *object)
+{
+    auto it = m_indexedObjects.find(object);
+    if (it == m_indexedObjects.end())
+        return;
+
+    disconnect(it.value().connection);
+
+    const QRect cells = viewportGridCells(it.value().rect);
+    for (int x = cells.left(); x <= cells.right(); x++) {
+        for (int y = cells.top(); y <= cells.bottom(); y++) {
+            auto cit = m_grid.find(viewportGridCellKey(x, y));
+            if (cit != m_grid.end()) {
+                cit.value().remove(object);
+                if (cit.value().isEmpty())
+                    m_grid.erase(cit);
+            }
+        }
+    }
+
+    m_indexedObjects.erase(it);
+}
+
+void StructureCanvasViewportFilterModel::updateObjectGeometry(QObject *object)
+{
+    auto it = m_indexedObjects.find(object);
+    if (it == m_indexedObjects.end())
+        return;
+
+    const QRectF rect = this->objectGeometry(object);
+    const QRect oldCells = viewportGridCells(it.value().rect);
+    const QRect newCells = viewportGridCells(rect);
+    it.value().rect = rect;
+
+    if (oldCells != newCells) {
+        for (int x = oldCells.left(); x <= oldCells.right(); x++) {
+            for (int y = oldCells.top(); y <= oldCells.bottom(); y++) {
+                if (newCells.contains(x, y))
+                    continue;
+
+                auto cit = m_grid.find(viewportGridCellKey(x, y));
+                if (cit != m_grid.end()) {
+                    cit.value().remove(object);
+                    if (cit.value().isEmpty())
+                        m_grid.erase(cit);
+                }
+            }
+        }
+
+        for (int x = newCells.left(); x <= newCells.right(); x++)
+            for (int y = newCells.top(); y <= newCells.bottom(); y++)
+                m_grid[viewportGridCellKey(x, y)].insert(object);
+    }
+
+    if (m_viewportRect.size().isEmpty())
+        return;
+
+    if (this->isObjectInViewport(rect) != m_visibleObjects.contains(object))
+        this->invalidateSelfLater();
+}
+
+void StructureCanvasViewportFilterModel::clearIndex()
+{
+    for (const IndexedObject &indexed : qAsConst(m_indexedObjects))
+        disconnect(indexed.connection);
+
+    m_indexedObjects.clear();
+    m_grid.clear();
+    m_visibleObjects.clear();
+    m_indexValid = false;
+}
+
+QSet<const QObject *> StructureCanvasViewportFilterModel::objectsInViewport() const
+{
+    QSet<const QObject *> ret;
+
+    // When zoomed out far enough, the viewport spans more cells than there are objects.
+    // It is cheaper to test each object then.
+    const QRect cells = viewportGridCells(m_viewportRect);
+    const qint64 nrCells = qint64(cells.width()) * qint64(cells.height());
+    if (nrCells > m_indexedObjects.size()) {
+        for (auto it = m_indexedObjects.constBegin(); it != m_indexedObjects.constEnd(); ++it) {
+            if (this->isObjectInViewport(it.value().rect))
+                ret.insert(it.key());
+        }
+        return ret;
+    }
+
+    for (int x = cells.left(); x <= cells.right(); x++) {
+        for (int y = cells.top(); y <= cells.bottom(); y++) {
+            const auto cit = m_grid.constFind(viewportGridCellKey(x, y));
+            if (cit == m_grid.constEnd())
+                continue;
+
+            for (QObject *object : cit.value()) {
+                if (!ret.contains(object)
+                    && this->isObjectInViewport(m_indexedObjects.value(object).rect))
+                    ret.insert(object);
+            }
+        }
+    }
+
+    return ret;
+}
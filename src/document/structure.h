@@ -1288,6 +1288,19 @@ private:
     void invalidateSelf();
     void invalidateSelfLater();
 
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceDataChanged();
+    void onSourceModelReset();
+
+    QRectF objectGeometry(const QObject *object) const;
+    bool isObjectInViewport(const QRectF &objectRect) const;
+    void indexObject(QObject *object);
+    void unindexObject(QObject *object);
+    void updateObjectGeometry(QObject *object);
+    void clearIndex();
+    QSet<const QObject *> objectsInViewport() const;
+
 private:
     bool m_enabled = true;
     QRectF m_viewportRect;
@@ -1296,7 +1309,18 @@ private:
     QObjectProperty<Structure> m_structure;
     FilterStrategy m_filterStrategy = IntersectsStrategy;
     ComputeStrategy m_computeStrategy = OnDemandComputeStrategy;
-    QList<QPair<const QObject *, bool>> m_visibleSourceRows;
+
+    // Uniform grid over the canvas, maintained from geometry changes of objects, so that
+    // objects in the viewport can be looked up without walking over all of them.
+    struct IndexedObject
+    {
+        QRectF rect;
+        QMetaObject::Connection connection;
+    };
+    bool m_indexValid = false;
+    QHash<QObject *, IndexedObject> m_indexedObjects;
+    QHash<quint64, QSet<QObject *>> m_grid;
+    QSet<const QObject *> m_visibleObjects;
 };
 
 #endif // STRUCTURE_H
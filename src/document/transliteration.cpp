@@ -138,6 +138,8 @@ TransliterationEngine::TransliterationEngine(QObject *parent) : QObject(parent)
         lang = Language(val);
     }
     this->setLanguage(lang);
+
+    this->updateLanguageFontFamilyTable();
 }
 
 void TransliterationEngine::setEnabledLanguages(const QList<int> &val)
@@ -635,7 +637,8 @@ QFont TransliterationEngine::languageFont(TransliterationEngine::Language langua
     if (fontFamily.isEmpty()) {
         const QStringList languageFontFamilies =
                 fontDb.families(writingSystemForLanguage(language));
-        fontFamily = languageFontFamilies.first();
+        if (!languageFontFamilies.isEmpty())
+            fontFamily = languageFontFamilies.first();
     }
 
     return fontFamily.isEmpty() ? Application::instance()->font() : QFont(fontFamily);
@@ -726,10 +729,25 @@ void TransliterationEngine::setPreferredFontFamilyForLanguage(
         settings->setValue(QStringLiteral("Transliteration/") + languageAsString(language)
                                    + QStringLiteral("_Font"),
                            after);
+        this->updateLanguageFontFamilyTable();
         emit preferredFontFamilyForLanguageChanged(language, after);
     }
 }
 
+void TransliterationEngine::updateLanguageFontFamilyTable()
+{
+    // Resolving a language font may query the font database, which is too slow to do
+    // for every run of text that is highlighted. So it is done once per font change.
+    const QMetaObject *mo = &TransliterationEngine::staticMetaObject;
+    const QMetaEnum languageEnum = mo->enumerator(mo->indexOfEnumerator("Language"));
+
+    m_languageFontFamilyTable = QVector<QString>(languageEnum.keyCount());
+    for (int i = 0; i < languageEnum.keyCount(); i++) {
+        const Language language = Language(languageEnum.value(i));
+        m_languageFontFamilyTable[int(language)] = this->languageFont(language).family();
+    }
+}
+
 TransliterationEngine::Language TransliterationEngine::languageForScript(QChar::Script script)
 {
     static QMap<QChar::Script, Language> scriptLanguageMap;
@@ -944,6 +962,61 @@ TransliterationEngine::evaluateBoundaries(const QString &text,
     return ret;
 }
 
+QVector<TransliterationEngine::ScriptRun>
+TransliterationEngine::evaluateScriptRuns(const QString &text)
+{
+    QVector<ScriptRun> ret;
+    if (text.isEmpty())
+        return ret;
+
+    ScriptRun run;
+    QChar::Script lastScript = QChar::Script_Common;
+    Language lastScriptLanguage = English;
+
+    const int length = text.length();
+    for (int i = 0; i < length; i++) {
+        const QChar::Script script = text.at(i).script();
+
+        Language language = English;
+        if (script == QChar::Script_Inherited)
+            language = run.language;
+        else if (script != QChar::Script_Common) {
+            // Consecutive characters are mostly of the same script, so the map
+            // lookup in languageForScript() is only done when the script changes.
+            if (script != lastScript) {
+                lastScript = script;
+                lastScriptLanguage = languageForScript(script);
+            }
+            language = lastScriptLanguage;
+        }
+
+        if (run.length > 0 && run.language != language) {
+            ret.append(run);
+            run.start = i;
+            run.length = 0;
+        }
+
+        run.language = language;
+        ++run.length;
+    }
+
+    ret.append(run);
+    return ret;
+}
+
+const QVector<TransliterationEngine::ScriptRun> &
+TransliterationEngine::ScriptRunCache::scriptRuns(const QString &text)
+{
+    const uint textHash = qHash(text);
+    if (textHash != m_textHash || text != m_text) {
+        m_textHash = textHash;
+        m_text = text;
+        m_scriptRuns = TransliterationEngine::evaluateScriptRuns(text);
+    }
+
+    return m_scriptRuns;
+}
+
 void TransliterationEngine::evaluateBoundariesAndInsertText(QTextCursor &cursor,
                                                             const QString &text) const
 {
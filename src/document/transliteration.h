@@ -129,6 +129,10 @@ public:
         return this->languageFont(language, true);
     }
     QFont languageFont(TransliterationEngine::Language language, bool preferAppFonts) const;
+    QString languageFontFamily(TransliterationEngine::Language language) const
+    {
+        return m_languageFontFamilyTable.value(int(language));
+    }
     QStringList languageFontFilePaths(TransliterationEngine::Language language) const;
 
     Q_INVOKABLE QJsonObject
@@ -159,6 +163,31 @@ public:
                                        bool bundleCommonScriptChars = false) const;
     void evaluateBoundariesAndInsertText(QTextCursor &cursor, const QString &text) const;
 
+    // Lightweight alternative to evaluateBoundaries() for syntax highlighters, which only
+    // need to know the language of each run of text. Common characters (spaces, digits,
+    // punctuation) are treated as English and combining marks stay with the preceding
+    // character, as evaluateBoundaries() does. Use languageFontFamily() to find the font
+    // family to apply to a run.
+    struct ScriptRun
+    {
+        int start = 0;
+        int length = 0;
+        TransliterationEngine::Language language = TransliterationEngine::English;
+    };
+    static QVector<ScriptRun> evaluateScriptRuns(const QString &text);
+
+    // Caches script runs of a paragraph in its block user data, so that they are evaluated
+    // again only after the text of the paragraph changes.
+    struct ScriptRunCache
+    {
+        const QVector<ScriptRun> &scriptRuns(const QString &text);
+
+    private:
+        uint m_textHash = 0;
+        QString m_text;
+        QVector<ScriptRun> m_scriptRuns;
+    };
+
     static QChar::Script determineScript(const QString &val);
 
     Q_INVOKABLE QString formattedHtmlOf(const QString &text) const;
@@ -174,6 +203,7 @@ private:
     TransliterationEngine(QObject *parent = nullptr);
     void setEnabledLanguages(const QList<int> &val);
     void determineEnabledLanguages();
+    void updateLanguageFontFamilyTable();
 
 private:
     void *m_transliterator = nullptr;
@@ -184,6 +214,7 @@ private:
     QMap<Language, int> m_languageBundledFontId;
     QMap<Language, QString> m_languageFontFamily;
     QMap<Language, QStringList> m_languageFontFilePaths;
+    QVector<QString> m_languageFontFamilyTable;
     mutable QMap<Language, QStringList> m_availableLanguageFontFamilies;
 };
 
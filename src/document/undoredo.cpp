@@ -66,14 +66,94 @@ static QByteArray objectUndoRedoLockProperty()
     return ret;
 }
 
-class ObjectPropertyInfoList : public QObject, public QList<ObjectPropertyInfo *>
+struct ObjectPropertyKey
+{
+    const QObject *object = nullptr;
+    const QMetaObject *metaObject = nullptr;
+    int propertyIndex = -1;
+
+    bool operator==(const ObjectPropertyKey &other) const
+    {
+        return this->object == other.object && this->metaObject == other.metaObject
+                && this->propertyIndex == other.propertyIndex;
+    }
+};
+
+inline uint qHash(const ObjectPropertyKey &key, uint seed = 0)
+{
+    return ::qHash(key.object, seed) ^ ::qHash(key.metaObject, seed) ^ uint(key.propertyIndex);
+}
+
+/**
+ * Undo commands are created for (object, property) pairs at a high rate, for
+ * example when index cards are dragged around on the structure canvas. So both
+ * the lookup of ObjectPropertyInfo and resolution of property names into indexes
+ * are hashed, instead of being scanned linearly.
+ */
+class ObjectPropertyInfoList : public QObject
 {
 public:
     explicit ObjectPropertyInfoList() : QObject() { qApp->installEventFilter(this); }
     ~ObjectPropertyInfoList()
     {
-        qDeleteAll(*this);
-        this->clear();
+        const QList<ObjectPropertyInfo *> infos = m_infos.values();
+        m_infos.clear();
+        m_objectInfos.clear();
+        qDeleteAll(infos);
+    }
+
+    struct ResolvedProperty
+    {
+        int index = -1;
+        const QMetaObject *metaObject = nullptr; // Class that declares the property
+        bool canUndo = false;
+    };
+
+    ResolvedProperty resolve(const QMetaObject *metaObject, const QByteArray &property)
+    {
+        QHash<QByteArray, ResolvedProperty> &properties = m_resolvedProperties[metaObject];
+        auto it = properties.find(property);
+        if (it != properties.end())
+            return it.value();
+
+        ResolvedProperty ret;
+        ret.index = metaObject->indexOfProperty(property);
+        if (ret.index >= 0) {
+            const QMetaProperty prop = metaObject->property(ret.index);
+            const bool isQQmlListProperty =
+                    QByteArray(prop.typeName()).startsWith("QQmlListProperty");
+            ret.canUndo = prop.isReadable() && (prop.isWritable() || isQQmlListProperty);
+
+            ret.metaObject = metaObject;
+            while (ret.metaObject != nullptr && ret.index < ret.metaObject->propertyOffset())
+                ret.metaObject = ret.metaObject->superClass();
+
+            // dont know why this would happen. Just being paranoid
+            if (ret.metaObject == nullptr)
+                ret.canUndo = false;
+        }
+
+        properties.insert(property, ret);
+        return ret;
+    }
+
+    ObjectPropertyInfo *find(const ObjectPropertyKey &key) const
+    {
+        return m_infos.value(key);
+    }
+
+    void add(ObjectPropertyInfo *info)
+    {
+        m_infos.insert(keyOf(info), info);
+        m_objectInfos.insert(info->object, info);
+    }
+
+    void remove(ObjectPropertyInfo *info)
+    {
+        const ObjectPropertyKey key = keyOf(info);
+        if (m_infos.value(key) == info)
+            m_infos.remove(key);
+        m_objectInfos.remove(info->object, info);
     }
 
     bool eventFilter(QObject *object, QEvent *event)
@@ -87,14 +167,29 @@ public:
 
         const bool locked = object->property(objectUndoRedoLockProperty()).toBool();
 
-        for (int i = 0; i < this->size(); i++) {
-            ObjectPropertyInfo *pinfo = this->at(i);
-            if (pinfo->object == object)
-                pinfo->m_objectIsLocked = locked;
+        auto it = m_objectInfos.find(object);
+        while (it != m_objectInfos.end() && it.key() == object) {
+            it.value()->m_objectIsLocked = locked;
+            ++it;
         }
 
         return false;
     }
+
+private:
+    static ObjectPropertyKey keyOf(const ObjectPropertyInfo *info)
+    {
+        ObjectPropertyKey key;
+        key.object = info->object;
+        key.metaObject = info->metaObject;
+        key.propertyIndex = info->propertyIndex;
+        return key;
+    }
+
+private:
+    QHash<ObjectPropertyKey, ObjectPropertyInfo *> m_infos;
+    QMultiHash<const QObject *, ObjectPropertyInfo *> m_objectInfos;
+    QHash<const QMetaObject *, QHash<QByteArray, ResolvedProperty>> m_resolvedProperties;
 };
 Q_GLOBAL_STATIC(ObjectPropertyInfoList, GlobalObjectPropertyInfoList);
 
@@ -118,22 +213,25 @@ static inline QList<QByteArray> queryPropertyBundle(QObject *object, const QByte
     return propertyBundle;
 }
 
-ObjectPropertyInfo::ObjectPropertyInfo(QObject *o, const QMetaObject *mo, const QByteArray &prop)
+ObjectPropertyInfo::ObjectPropertyInfo(QObject *o, const QMetaObject *mo, int propIndex,
+                                       const QByteArray &prop)
     : id(++ObjectPropertyInfo::counter),
       object(o),
       property(prop),
+      propertyIndex(propIndex),
       metaObject(mo),
       propertyBundle(queryPropertyBundle(o, prop))
 {
     m_objectIsLocked = o->property(objectUndoRedoLockProperty()).toBool();
     m_connection = QObject::connect(o, &QObject::destroyed, o, [this]() { this->deleteSelf(); });
 
-    ::GlobalObjectPropertyInfoList->append(this);
+    ::GlobalObjectPropertyInfoList->add(this);
 }
 
 ObjectPropertyInfo::~ObjectPropertyInfo()
 {
-    ::GlobalObjectPropertyInfoList->removeOne(this);
+    if (!::GlobalObjectPropertyInfoList.isDestroyed())
+        ::GlobalObjectPropertyInfoList->remove(this);
     QObject::disconnect(m_connection);
 }
 
@@ -163,33 +261,23 @@ bool ObjectPropertyInfo::write(const QVariant &val)
 
 ObjectPropertyInfo *ObjectPropertyInfo::get(QObject *object, const QByteArray &property)
 {
-    const QMetaObject *metaObject = object->metaObject();
-    const int propIndex = metaObject->indexOfProperty(property);
-    if (propIndex < 0)
-        return nullptr;
-
-    const QMetaProperty prop = metaObject->property(propIndex);
-    if (!prop.isReadable())
-        return nullptr;
+    ObjectPropertyInfoList &list = *::GlobalObjectPropertyInfoList();
 
-    const bool isQQmlListProperty = QByteArray(prop.typeName()).startsWith("QQmlListProperty");
-    if (!prop.isWritable() && !isQQmlListProperty)
+    const ObjectPropertyInfoList::ResolvedProperty prop =
+            list.resolve(object->metaObject(), property);
+    if (prop.index < 0 || !prop.canUndo)
         return nullptr;
 
-    while (metaObject != nullptr && propIndex < metaObject->propertyOffset())
-        metaObject = metaObject->superClass();
-
-    if (metaObject == nullptr)
-        return nullptr; // dont know why this would happen. Just being paranoid
+    ObjectPropertyKey key;
+    key.object = object;
+    key.metaObject = prop.metaObject;
+    key.propertyIndex = prop.index;
 
-    ObjectPropertyInfoList &list = *::GlobalObjectPropertyInfoList();
-    for (int i = 0; i < list.size(); i++) {
-        ObjectPropertyInfo *info = list.at(i);
-        if (info->object == object && info->metaObject == metaObject && info->property == property)
-            return info;
-    }
+    ObjectPropertyInfo *info = list.find(key);
+    if (info != nullptr)
+        return info;
 
-    return new ObjectPropertyInfo(object, metaObject, property);
+    return new ObjectPropertyInfo(object, prop.metaObject, prop.index, property);
 }
 
 void ObjectPropertyInfo::lockUndoRedoFor(QObject *object)
@@ -209,7 +297,8 @@ int ObjectPropertyInfo::querySetCounter(QObject *object, const QByteArray &prope
     if (object == nullptr || property.isEmpty())
         return -1;
 
-    const int propIndex = object->metaObject()->indexOfProperty(property);
+    const int propIndex =
+            ::GlobalObjectPropertyInfoList->resolve(object->metaObject(), property).index;
     if (propIndex < 0)
         return -1;
 
@@ -54,6 +54,7 @@ struct ObjectPropertyInfo
     const int id = -1;
     const QObject *object = nullptr;
     const QByteArray property;
+    const int propertyIndex = -1;
     const QMetaObject *metaObject = nullptr;
     const QList<QByteArray> propertyBundle;
 
@@ -72,7 +73,7 @@ struct ObjectPropertyInfo
 
 private:
     friend class ObjectPropertyInfoList;
-    ObjectPropertyInfo(QObject *o, const QMetaObject *mo, const QByteArray &prop);
+    ObjectPropertyInfo(QObject *o, const QMetaObject *mo, int propIndex, const QByteArray &prop);
     void deleteSelf();
 
     static int counter;
@@ -15,6 +15,7 @@
 #include "application.h"
 #include "scrite.h"
 #include "user.h"
+#include "invalidationscheduler.h"
 
 #include <QBuffer>
 #include <QClipboard>
@@ -81,6 +82,8 @@ bool AbstractExporter::write(AbstractExporter::Target target)
         return false;
     }
 
+    InvalidationScheduler::flushCurrentThread();
+
     QScopedPointer<QIODevice> device;
 
     if (target == FileTarget) {
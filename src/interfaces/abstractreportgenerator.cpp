@@ -16,6 +16,7 @@
 #include "user.h"
 #include "scrite.h"
 #include "application.h"
+#include "invalidationscheduler.h"
 #include "qtextdocumentpagedprinter.h"
 
 #include <QDir>
@@ -133,6 +134,8 @@ bool AbstractReportGenerator::generate()
         return false;
     }
 
+    InvalidationScheduler::flushCurrentThread();
+
     if (fileName.isEmpty()) {
         this->error()->setErrorMessage("Cannot export to an empty file.");
         return false;
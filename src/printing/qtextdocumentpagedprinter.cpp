@@ -20,12 +20,17 @@
 
 #include <QDate>
 #include <QTime>
+#include <QFuture>
+#include <QThread>
 #include <QtDebug>
 #include <QPainter>
+#include <QPicture>
 #include <QDateTime>
 #include <QSettings>
 #include <QTextBlock>
 #include <QPaintEngine>
+#include <QFontDatabase>
+#include <QtConcurrentRun>
 #include <QAbstractTextDocumentLayout>
 
 HeaderFooter::HeaderFooter(Type type, QObject *parent) : QObject(parent), m_type(type)
@@ -212,6 +217,7 @@ void Watermark::setText(const QString &val)
         return;
 
     m_text = val;
+    m_paintCache = PaintCache();
     emit textChanged();
 }
 
@@ -221,6 +227,7 @@ void Watermark::setFont(const QFont &val)
         return;
 
     m_font = val;
+    m_paintCache = PaintCache();
     emit fontChanged();
 }
 
@@ -250,6 +257,7 @@ void Watermark::setRotation(qreal val)
         return;
 
     m_rotation = val;
+    m_paintCache = PaintCache();
     emit rotationChanged();
 }
 
@@ -259,6 +267,7 @@ void Watermark::setAlignment(Qt::Alignment val)
         return;
 
     m_alignment = val;
+    m_paintCache = PaintCache();
     emit alignmentChanged();
 }
 
@@ -290,42 +299,55 @@ void Watermark::paint(QPainter *painter, const QRectF &pageRect, int pageNr, int
     if (!m_visibleFromPageOne && pageNr == 1)
         return;
 
-    const QPointF pageCenter = pageRect.center();
+    const QPaintDevice *device = painter->device();
+    if (m_paintCache.logicalDpiX != device->logicalDpiX()
+        || m_paintCache.logicalDpiY != device->logicalDpiY() || m_paintCache.pageRect != pageRect) {
+        const QPointF pageCenter = pageRect.center();
+
+        QFontMetricsF fm(m_font, painter->device());
+        QRectF textRect = fm.boundingRect(m_text);
+
+        QTransform tx;
+        tx.translate(textRect.center().x(), textRect.center().y());
+        tx.rotate(m_rotation);
+        tx.translate(-textRect.center().x(), -textRect.center().y());
+        QRectF rotatedTextRect = tx.mapRect(textRect);
+
+        if (m_alignment.testFlag(Qt::AlignLeft))
+            rotatedTextRect.moveLeft(pageRect.left());
+        else if (m_alignment.testFlag(Qt::AlignRight))
+            rotatedTextRect.moveRight(pageRect.right());
+        else {
+            const QPointF textCenter = rotatedTextRect.center();
+            rotatedTextRect.moveCenter(QPointF(pageCenter.x(), textCenter.y()));
+        }
 
-    QFontMetricsF fm(m_font, painter->device());
-    QRectF textRect = fm.boundingRect(m_text);
+        if (m_alignment.testFlag(Qt::AlignTop))
+            rotatedTextRect.moveTop(pageRect.top());
+        else if (m_alignment.testFlag(Qt::AlignBottom))
+            rotatedTextRect.moveBottom(pageRect.bottom());
+        else {
+            const QPointF textCenter = rotatedTextRect.center();
+            rotatedTextRect.moveCenter(QPointF(textCenter.x(), pageCenter.y()));
+        }
 
-    QTransform tx;
-    tx.translate(textRect.center().x(), textRect.center().y());
-    tx.rotate(m_rotation);
-    tx.translate(-textRect.center().x(), -textRect.center().y());
-    QRectF rotatedTextRect = tx.mapRect(textRect);
+        textRect.moveCenter(rotatedTextRect.center());
 
-    if (m_alignment.testFlag(Qt::AlignLeft))
-        rotatedTextRect.moveLeft(pageRect.left());
-    else if (m_alignment.testFlag(Qt::AlignRight))
-        rotatedTextRect.moveRight(pageRect.right());
-    else {
-        const QPointF textCenter = rotatedTextRect.center();
-        rotatedTextRect.moveCenter(QPointF(pageCenter.x(), textCenter.y()));
-    }
+        qreal scale = 1.0;
+        if (rotatedTextRect.width() > pageRect.width())
+            scale = qMin(scale, pageRect.width() / rotatedTextRect.width());
+        if (rotatedTextRect.height() > pageRect.height())
+            scale = qMin(scale, pageRect.height() / rotatedTextRect.height());
 
-    if (m_alignment.testFlag(Qt::AlignTop))
-        rotatedTextRect.moveTop(pageRect.top());
-    else if (m_alignment.testFlag(Qt::AlignBottom))
-        rotatedTextRect.moveBottom(pageRect.bottom());
-    else {
-        const QPointF textCenter = rotatedTextRect.center();
-        rotatedTextRect.moveCenter(QPointF(textCenter.x(), pageCenter.y()));
+        m_paintCache.logicalDpiX = device->logicalDpiX();
+        m_paintCache.logicalDpiY = device->logicalDpiY();
+        m_paintCache.pageRect = pageRect;
+        m_paintCache.textRect = textRect;
+        m_paintCache.scale = scale;
     }
 
-    textRect.moveCenter(rotatedTextRect.center());
-
-    qreal scale = 1.0;
-    if (rotatedTextRect.width() > pageRect.width())
-        scale = qMin(scale, pageRect.width() / rotatedTextRect.width());
-    if (rotatedTextRect.height() > pageRect.height())
-        scale = qMin(scale, pageRect.height() / rotatedTextRect.height());
+    const QRectF &textRect = m_paintCache.textRect;
+    const qreal scale = m_paintCache.scale;
 
     painter->save();
 
@@ -365,6 +387,102 @@ private:
     T **m_ptr;
 };
 
+static QRectF documentPageRect(const QRectF &body, int pageNr)
+{
+    return QRectF(0, (pageNr - 1) * body.height(), body.width(), body.height());
+}
+
+static void paintPageContents(QPainter *painter, const QTextDocument *doc, const QRectF &body,
+                              int pageNr)
+{
+    painter->save();
+
+    painter->translate(body.left(), body.top() - (pageNr - 1) * body.height());
+    const QRectF pageRect = documentPageRect(body, pageNr);
+
+    QAbstractTextDocumentLayout *layout = doc->documentLayout();
+    QAbstractTextDocumentLayout::PaintContext ctx;
+
+    painter->setClipRect(pageRect);
+    ctx.clip = pageRect;
+    ctx.palette.setColor(QPalette::Text, Qt::black);
+    layout->draw(painter, ctx);
+
+    painter->restore();
+}
+
+static void copyTextLayoutFormats(const QTextDocument *from, QTextDocument *to)
+{
+    for (QTextBlock srcBlock = from->firstBlock(), dstBlock = to->firstBlock();
+         srcBlock.isValid() && dstBlock.isValid();
+         srcBlock = srcBlock.next(), dstBlock = dstBlock.next()) {
+        dstBlock.layout()->setFormats(srcBlock.layout()->formats());
+    }
+}
+
+/**
+ * Clones of a document are laid out again by the default document layout, which knows nothing
+ * about handlers registered with the original layout for custom text objects.
+ */
+static bool hasCustomTextObjects(const QTextDocument *doc)
+{
+    const QVector<QTextFormat> formats = doc->allFormats();
+    for (const QTextFormat &format : formats) {
+        if (format.objectType() >= QTextFormat::UserObject)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Runs in a background thread. QTextDocument is not thread-safe, and drawing it updates caches
+ * in its layout. So each thread draws its own clone of the document, which is handed over without
+ * thread affinity, so that it can be pulled into this thread. Contents of pages fromPageNr till
+ * toPageNr are recorded into pictures.
+ */
+static QVector<QPicture> QTextDocumentPagedPrinter_RenderPagesTask(QTextDocument *clonedDoc,
+                                                                   const QRectF &body,
+                                                                   int fromPageNr, int toPageNr)
+{
+    QScopedPointer<QTextDocument> doc(clonedDoc);
+    doc->moveToThread(QThread::currentThread());
+
+    QVector<QPicture> pictures;
+    pictures.reserve(toPageNr - fromPageNr + 1);
+
+    for (int pageNr = fromPageNr; pageNr <= toPageNr; pageNr++) {
+        QPicture picture;
+        QPainter painter(&picture);
+        paintPageContents(&painter, doc.data(), body, pageNr);
+        painter.end();
+        pictures.append(picture);
+    }
+
+    return pictures;
+}
+
+/**
+ * Splits pages into one range per thread. The calling thread prints the first range straight
+ * from the document, while others are rendered from clones. Every clone has to be laid out
+ * again up to the end of its range, so there is nothing to gain from smaller ranges.
+ */
+static QList<QPair<int, int>> concurrentPageRanges(int pageCount)
+{
+    QList<QPair<int, int>> ret;
+
+    const int nrThreads = QThread::idealThreadCount();
+    if (nrThreads < 2 || pageCount < 8)
+        return ret;
+
+    const int nrRanges = qMin(nrThreads, pageCount / 4);
+    const int pagesPerRange = (pageCount + nrRanges - 1) / nrRanges;
+    for (int fromPageNr = 1; fromPageNr <= pageCount; fromPageNr += pagesPerRange)
+        ret << qMakePair(fromPageNr, qMin(fromPageNr + pagesPerRange - 1, pageCount));
+
+    return ret;
+}
+
 bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice *printer)
 {
     Pointer<QTextDocument> td(&m_textDocument);
@@ -410,6 +528,7 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
 
     QRectF body = QRectF(QPointF(0, 0), pageSize);
     QPair<qreal, qreal> contentScale = qMakePair(1.0, 1.0);
+    bool renderPagesConcurrently = false;
 
     if (documentPaginated) {
         // Documents generated using ScreenplayTextDocument will come paginated.
@@ -423,6 +542,15 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
             sourceDpiY = dev->logicalDpiY();
         }
 
+        // Pictures record page contents at their own resolution, which must match the layout's.
+        // Clones are laid out without a paint device, so the original must not have one either.
+        // Pages are rendered sequentially if fonts cannot be rendered outside the GUI thread.
+        const QPicture picture;
+        renderPagesConcurrently = dev == nullptr
+                && QFontDatabase::supportsThreadedFontRendering() && !hasCustomTextObjects(doc)
+                && qFuzzyCompare(sourceDpiX, qreal(picture.logicalDpiX()))
+                && qFuzzyCompare(sourceDpiY, qreal(picture.logicalDpiY()));
+
         // scale to dpi
         const qreal dpiScaleX = qreal(printer->logicalDpiX()) / sourceDpiX;
         const qreal dpiScaleY = qreal(printer->logicalDpiY()) / sourceDpiY;
@@ -443,11 +571,7 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
         doc = document->clone(this);
         clonedDoc.reset(const_cast<QTextDocument *>(doc));
 
-        for (QTextBlock srcBlock = document->firstBlock(), dstBlock = clonedDoc->firstBlock();
-             srcBlock.isValid() && dstBlock.isValid();
-             srcBlock = srcBlock.next(), dstBlock = dstBlock.next()) {
-            dstBlock.layout()->setFormats(srcBlock.layout()->formats());
-        }
+        copyTextLayoutFormats(document, clonedDoc.data());
 
         QAbstractTextDocumentLayout *layout = doc->documentLayout();
         layout->setPaintDevice(painter.device());
@@ -542,11 +666,45 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
 
     const bool isPdfDevice = printer->paintEngine()->type() == QPaintEngine::Pdf;
 
+    // Contents of pages after the first range are recorded into pictures by background threads,
+    // which are then played into the printer in page order as they become available.
+    QList<QPair<int, int>> pageRanges;
+    QList<QFuture<QVector<QPicture>>> pageRangeFutures;
+    if (renderPagesConcurrently) {
+        pageRanges = concurrentPageRanges(toPageNr);
+        for (int i = 1; i < pageRanges.size(); i++) {
+            // Clones are made here, because reading a document is not thread-safe either.
+            QTextDocument *rangeDoc = doc->clone();
+            copyTextLayoutFormats(doc, rangeDoc);
+            rangeDoc->moveToThread(nullptr);
+
+            const QPair<int, int> pageRange = pageRanges.at(i);
+            pageRangeFutures << QtConcurrent::run(QTextDocumentPagedPrinter_RenderPagesTask,
+                                                  rangeDoc, body, pageRange.first,
+                                                  pageRange.second);
+        }
+    }
+
+    int pageRangeIndex = 0;
+    QVector<QPicture> pageRangePictures;
+
     // Print away!
     while (pageNr <= toPageNr) {
+        if (pageRangeIndex + 1 < pageRanges.size()
+            && pageRanges.at(pageRangeIndex + 1).first == pageNr) {
+            ++pageRangeIndex;
+            pageRangePictures = pageRangeFutures.at(pageRangeIndex - 1).result();
+        }
+
         painter.save();
         painter.scale(contentScale.first, contentScale.second);
-        this->printPageContents(pageNr, toPageNr, &painter, doc, body, pageRect);
+        if (pageRangeIndex == 0)
+            this->printPageContents(pageNr, toPageNr, &painter, doc, body, pageRect);
+        else {
+            const int pictureIndex = pageNr - pageRanges.at(pageRangeIndex).first;
+            painter.drawPicture(QPointF(0, 0), pageRangePictures.at(pictureIndex));
+            pageRect = documentPageRect(body, pageNr);
+        }
         if (!isPdfDevice)
             this->printHeaderFooterWatermark(pageNr, toPageNr, &painter, doc, body, pageRect);
         painter.restore();
@@ -564,6 +722,10 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
         ++pageNr;
     }
 
+    // Background threads may still be drawing their clones, if printing was cut short.
+    for (QFuture<QVector<QPicture>> &future : pageRangeFutures)
+        future.waitForFinished();
+
     // All done!
     m_header->finish();
     m_footer->finish();
@@ -613,21 +775,8 @@ void QTextDocumentPagedPrinter::printPageContents(int pageNr, int pageCount, QPa
 {
     Q_UNUSED(pageCount)
 
-    painter->save();
-
-    painter->translate(body.left(), body.top() - (pageNr - 1) * body.height());
-    const QRectF pageRect(0, (pageNr - 1) * body.height(), body.width(), body.height());
-    docPageRect = pageRect;
-
-    QAbstractTextDocumentLayout *layout = doc->documentLayout();
-    QAbstractTextDocumentLayout::PaintContext ctx;
-
-    painter->setClipRect(pageRect);
-    ctx.clip = pageRect;
-    ctx.palette.setColor(QPalette::Text, Qt::black);
-    layout->draw(painter, ctx);
-
-    painter->restore();
+    docPageRect = documentPageRect(body, pageNr);
+    paintPageContents(painter, doc, body, pageNr);
 }
 
 void QTextDocumentPagedPrinter::printHeaderFooterWatermark(int pageNr, int pageCount,
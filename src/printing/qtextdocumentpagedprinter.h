@@ -197,6 +197,16 @@ private:
     bool m_visibleFromPageOne = false;
     char m_padding[2];
     QRectF m_rect;
+
+    // Watermark is painted identically on every page, so its geometry is evaluated only once.
+    struct PaintCache
+    {
+        int logicalDpiX = 0;
+        int logicalDpiY = 0;
+        QRectF pageRect;
+        QRectF textRect;
+        qreal scale = 1.0;
+    } m_paintCache;
 };
 
 class QTextDocumentPageSideBarInterface
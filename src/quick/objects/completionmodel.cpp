@@ -15,6 +15,7 @@
 #include "timeprofiler.h"
 #include "application.h"
 
+#include <QSet>
 #include <QKeyEvent>
 #include <QtConcurrentRun>
 #include <QGuiApplication>
@@ -249,29 +250,46 @@ void CompletionModel::filterStrings()
     bool someFilteringHappened = false;
     QStringList fstrings;
     if (m_completionPrefix.isEmpty())
-        fstrings = m_strings2;
+        fstrings = m_maxVisibleItems > 0 ? m_strings2.mid(0, m_maxVisibleItems) : m_strings2;
     else {
-        if (m_completionPrefix.isEmpty())
-            fstrings = m_strings2;
+        // Strings starting with the prefix form a contiguous range in m_sortedStrings2,
+        // beginning where the prefix itself would be.
+        typedef QPair<QString, int> SortedString;
+        const QString prefix = m_completionPrefix.toCaseFolded();
+        const auto begin = std::lower_bound(
+                m_sortedStrings2.constBegin(), m_sortedStrings2.constEnd(), prefix,
+                [](const SortedString &item, const QString &value) { return item.first < value; });
+        const auto end =
+                std::partition_point(begin, m_sortedStrings2.constEnd(),
+                                     [&](const SortedString &item) {
+                                         return item.first.startsWith(prefix);
+                                     });
+
         // if an exact match was found, then clear the completion model
         // even if there is another potential match possible.
-        else if (m_strings2.contains(m_completionPrefix, Qt::CaseInsensitive))
-            fstrings.clear();
-        else
-            std::copy_if(m_strings2.begin(), m_strings2.end(), std::back_inserter(fstrings),
-                         [&](const QString &item) {
-                             const bool ret =
-                                     item.startsWith(m_completionPrefix, Qt::CaseInsensitive);
-                             someFilteringHappened |= !ret;
-                             return ret;
-                         });
+        if (begin != end && begin->first != prefix) {
+            QVector<int> rows;
+            rows.reserve(int(std::distance(begin, end)));
+            std::transform(begin, end, std::back_inserter(rows),
+                           [](const SortedString &item) { return item.second; });
+
+            // Only the first few rows, in the order of m_strings2, are going to be shown.
+            int nrRows = rows.size();
+            if (m_maxVisibleItems > 0 && nrRows > m_maxVisibleItems) {
+                nrRows = m_maxVisibleItems;
+                std::partial_sort(rows.begin(), rows.begin() + nrRows, rows.end());
+            } else
+                std::sort(rows.begin(), rows.end());
+
+            fstrings.reserve(nrRows);
+            for (int i = 0; i < nrRows; i++)
+                fstrings.append(m_strings2.at(rows.at(i)));
+
+            someFilteringHappened = rows.size() < m_strings2.size();
+        }
     }
 
-    this->beginResetModel();
-    m_filteredStrings = fstrings.isEmpty() ? fstrings
-            : m_maxVisibleItems > 0        ? fstrings.mid(0, m_maxVisibleItems)
-                                           : fstrings;
-    this->endResetModel();
+    this->setFilteredStrings(fstrings);
 
     if (m_filteredStrings.isEmpty() || !someFilteringHappened)
         this->setCurrentRow(-1);
@@ -291,31 +309,71 @@ void CompletionModel::prepareStrings()
         m_strings2 = m_strings;
     m_strings2.removeDuplicates();
 
+    QSet<QString> foldedStrings2;
+    foldedStrings2.reserve(m_strings2.size());
+    for (const QString &item : qAsConst(m_strings2))
+        foldedStrings2.insert(item.toCaseFolded());
+
     std::copy_if(m_priorityStrings.begin(), m_priorityStrings.end(),
-                 std::back_inserter(m_priorityStrings2), [=](const QString &item) {
-                     return m_strings2.contains(item, Qt::CaseInsensitive);
+                 std::back_inserter(m_priorityStrings2), [&](const QString &item) {
+                     return foldedStrings2.contains(item.toCaseFolded());
                  });
     m_priorityStrings2.removeDuplicates();
 
     if (m_sortStrings)
         std::sort(m_strings2.begin(), m_strings2.end());
 
-    for (int i = m_priorityStrings2.size() - 1; i >= 0; i--) {
-        const QString priorityString2 = m_priorityStrings2.at(i);
-        m_strings2.removeOne(priorityString2);
-        m_strings2.prepend(priorityString2);
+    if (!m_priorityStrings2.isEmpty()) {
+        const QSet<QString> prioritySet(m_priorityStrings2.begin(), m_priorityStrings2.end());
+        QStringList strings2 = m_priorityStrings2;
+        std::copy_if(m_strings2.begin(), m_strings2.end(), std::back_inserter(strings2),
+                     [&](const QString &item) { return !prioritySet.contains(item); });
+        m_strings2 = strings2;
     }
 
+    m_sortedStrings2.clear();
+    m_sortedStrings2.reserve(m_strings2.size());
+    for (int i = 0; i < m_strings2.size(); i++)
+        m_sortedStrings2.append(qMakePair(m_strings2.at(i).toCaseFolded(), i));
+    std::sort(m_sortedStrings2.begin(), m_sortedStrings2.end());
+
     this->filterStrings();
 }
 
 void CompletionModel::clearFilterStrings()
 {
-    if (!m_filteredStrings.isEmpty()) {
-        this->beginResetModel();
-        m_filteredStrings.clear();
-        this->endResetModel();
+    this->setFilteredStrings(QStringList());
+    this->setCurrentRow(-1);
+}
+
+void CompletionModel::setFilteredStrings(const QStringList &val)
+{
+    // Rows common to the start and end of both lists stay, only the ones in between are
+    // removed and inserted. Views then keep their delegates for rows that didn't change.
+    const int oldCount = m_filteredStrings.size();
+    const int newCount = val.size();
+    const int minCount = qMin(oldCount, newCount);
+
+    int head = 0;
+    while (head < minCount && m_filteredStrings.at(head) == val.at(head))
+        ++head;
+
+    int tail = 0;
+    while (tail < minCount - head
+           && m_filteredStrings.at(oldCount - 1 - tail) == val.at(newCount - 1 - tail))
+        ++tail;
+
+    if (oldCount - tail > head) {
+        this->beginRemoveRows(QModelIndex(), head, oldCount - tail - 1);
+        m_filteredStrings.erase(m_filteredStrings.begin() + head,
+                                m_filteredStrings.begin() + (oldCount - tail));
+        this->endRemoveRows();
     }
 
-    this->setCurrentRow(-1);
+    if (newCount - tail > head) {
+        this->beginInsertRows(QModelIndex(), head, newCount - tail - 1);
+        for (int i = head; i < newCount - tail; i++)
+            m_filteredStrings.insert(i, val.at(i));
+        this->endInsertRows();
+    }
 }
@@ -106,6 +106,7 @@ private:
     void filterStrings();
     void prepareStrings();
     void clearFilterStrings();
+    void setFilteredStrings(const QStringList &val);
 
 private:
     int m_currentRow = -1;
@@ -117,6 +118,7 @@ private:
     int m_maxVisibleItems = 7;
     QString m_completionPrefix;
     QStringList m_strings2;
+    QVector<QPair<QString, int>> m_sortedStrings2; // case folded m_strings2 and row, sorted
     QStringList m_priorityStrings2;
     QStringList m_filteredStrings;
     bool m_filterKeyStrokes = false;
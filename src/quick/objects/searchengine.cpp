@@ -18,6 +18,8 @@
 #include <QJsonObject>
 #include <QTextCursor>
 #include <QTimerEvent>
+#include <QRegularExpression>
+#include <QTextBoundaryFinder>
 
 SearchAgent::SearchAgent(QObject *parent)
     : QObject(parent), m_engine(this, "engine"), m_textDocument(this, "textDocument")
@@ -109,8 +111,8 @@ void SearchAgent::setCurrentSearchResultIndex(int val)
     if (val < 0 || val >= m_textDocumentSearchResults.size())
         return;
 
-    const QPair<int, int> result = m_textDocumentSearchResults.at(val);
-    emit highlightText(result.first, result.second);
+    const TextMatch &result = m_textDocumentSearchResults.at(val);
+    emit highlightText(result.from, result.to + 1);
 }
 
 void SearchAgent::setTextDocument(QQuickTextDocument *val)
@@ -163,21 +165,10 @@ void SearchAgent::onSearchRequest(const QString &string)
     if (string.isEmpty())
         return;
 
-    QTextDocument *document = m_textDocument->textDocument();
-    QTextDocument::FindFlags flags;
-    if (m_engine != nullptr)
-        flags &= int(m_engine->searchFlags());
-
-    QTextCursor cursor(document);
-    while (1) {
-        cursor = document->find(string, cursor, flags);
-        if (cursor.isNull())
-            break;
-
-        m_textDocumentSearchResults
-                << qMakePair<int, int>(cursor.selectionStart(), cursor.selectionEnd());
-        cursor.setPosition(cursor.selectionEnd());
-    }
+    // Positions in the plain text of a document are also positions in the document.
+    const QString text = m_textDocument->textDocument()->toPlainText();
+    const int flags = m_engine != nullptr ? int(m_engine->searchFlags()) : 0;
+    m_textDocumentSearchResults = SearchEngine::matchesOf(string, text, flags);
 
     this->setSearchResultCount(m_textDocumentSearchResults.size());
 }
@@ -300,40 +291,109 @@ void SearchEngine::cycleSearchResult()
     }
 }
 
-QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int givenFlags)
+static QRegularExpression searchExpression(const QString &pattern, Qt::CaseSensitivity cs)
+{
+    // All agents search for the same pattern during a search. Holding on to the last
+    // compiled expression means that it gets compiled only once for all of them.
+    QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+    if (cs == Qt::CaseInsensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+
+    thread_local QRegularExpression lastExpression;
+    if (lastExpression.pattern() != pattern || lastExpression.patternOptions() != options) {
+        lastExpression = QRegularExpression(pattern, options);
+        lastExpression.optimize();
+    }
+
+    return lastExpression;
+}
+
+TextMatches SearchEngine::matchesOf(const QString &of, const QString &in, int givenFlags)
 {
+    TextMatches ret;
+    if (of.isEmpty() || in.isEmpty())
+        return ret;
+
     SearchEngine::SearchFlags flags(givenFlags);
     Qt::CaseSensitivity cs = Qt::CaseInsensitive;
 
     if (flags.testFlag(SearchEngine::SearchCaseSensitively))
         cs = Qt::CaseSensitive;
 
-    auto createResultItem = [](int from, int to) {
-        QJsonObject item;
-        item.insert("from", from);
-        item.insert("to", to);
-        return item;
+    // Whole words are bounded by word boundaries on both ends. QTextBoundaryFinder knows
+    // about punctuation and combining marks, which matters for Indic scripts.
+    const bool wholeWords = flags.testFlag(SearchEngine::SearchWholeWords);
+    QTextBoundaryFinder wordFinder;
+    if (wholeWords)
+        wordFinder = QTextBoundaryFinder(QTextBoundaryFinder::Word, in);
+
+    auto appendMatch = [&](int from, int length) {
+        if (length <= 0)
+            return;
+
+        if (wholeWords) {
+            wordFinder.setPosition(from);
+            if (!wordFinder.isAtBoundary())
+                return;
+            wordFinder.setPosition(from + length);
+            if (!wordFinder.isAtBoundary())
+                return;
+        }
+
+        TextMatch match;
+        match.from = from;
+        match.to = from + length - 1;
+        ret.append(match);
     };
 
-    QJsonArray ret;
+    if (flags.testFlag(SearchEngine::SearchRegularExpression)) {
+        const QRegularExpression rx = searchExpression(of, cs);
+        if (!rx.isValid())
+            return ret;
+
+        QRegularExpressionMatchIterator it = rx.globalMatch(in);
+        while (it.hasNext()) {
+            const QRegularExpressionMatch match = it.next();
+            appendMatch(match.capturedStart(), match.capturedLength());
+        }
+
+        return ret;
+    }
+
     int from = 0;
     while (1) {
         int pos = in.indexOf(of, from, cs);
         if (pos < 0)
             break;
 
-        if (flags.testFlag(SearchEngine::SearchWholeWords)) {
-            if (pos + of.length() >= in.length() || in.at(pos + of.length()).isSpace())
-                ret.append(createResultItem(pos, pos + of.length() - 1));
-        } else
-            ret.append(createResultItem(pos, pos + of.length() - 1));
-
+        appendMatch(pos, of.length());
         from = pos + of.length();
     }
 
     return ret;
 }
 
+QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int flags)
+{
+    return toJson(matchesOf(of, in, flags));
+}
+
+QJsonArray SearchEngine::toJson(const TextMatches &matches)
+{
+    QJsonArray ret;
+
+    const QString _from = QStringLiteral("from");
+    const QString _to = QStringLiteral("to");
+    for (const TextMatch &match : matches) {
+        QJsonObject item;
+        item.insert(_from, match.from);
+        item.insert(_to, match.to);
+        ret.append(item);
+    }
+
+    return ret;
+}
+
 QString SearchEngine::createMarkupText(const QString &text, int from, int to, const QBrush &bg,
                                        const QBrush &fg)
 {
@@ -575,8 +635,8 @@ void TextDocumentSearch::setCurrentResultIndex(int val)
     if (val < 0 || val >= m_searchResults.size())
         return;
 
-    const QPair<int, int> result = m_searchResults.at(val);
-    emit highlightText(result.first, result.second);
+    const TextMatch &result = m_searchResults.at(val);
+    emit highlightText(result.from, result.to + 1);
 }
 
 void TextDocumentSearch::setSearchFlags(SearchEngine::SearchFlags val)
@@ -586,6 +646,11 @@ void TextDocumentSearch::setSearchFlags(SearchEngine::SearchFlags val)
 
     m_searchFlags = val;
     emit searchFlagsChanged();
+
+    if (!m_searchString.isEmpty()) {
+        const QString searchString = m_searchString; // doSearch() clears m_searchString
+        this->doSearch(searchString);
+    }
 }
 
 void TextDocumentSearch::clearSearch()
@@ -633,20 +698,19 @@ void TextDocumentSearch::replace(const QString &replacementText)
     if (document == nullptr)
         return;
 
-    const QPair<int, int> result = m_searchResults.at(m_currentResultIndex);
+    const TextMatch result = m_searchResults.at(m_currentResultIndex);
 
     QTextCursor cursor(document);
-    cursor.setPosition(result.first);
-    cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor,
-                        result.second - result.first);
+    cursor.setPosition(result.from);
+    cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, result.length());
     if (cursor.selectedText() != replacementText) {
         const int diff = replacementText.length() - cursor.selectedText().length();
         cursor.insertText(replacementText);
 
         if (diff != 0 && m_currentResultIndex < m_searchResults.size() - 1) {
             for (int i = m_currentResultIndex + 1; i < m_searchResults.size(); i++) {
-                m_searchResults[i].first += diff;
-                m_searchResults[i].second += diff;
+                m_searchResults[i].from += diff;
+                m_searchResults[i].to += diff;
             }
         }
     }
@@ -663,10 +727,9 @@ void TextDocumentSearch::replaceAll(const QString &replacementText)
 
     QTextCursor cursor(document);
     for (int i = m_searchResults.size() - 1; i >= 0; i--) {
-        const QPair<int, int> result = m_searchResults.at(i);
-        cursor.setPosition(result.first);
-        cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor,
-                            result.second - result.first);
+        const TextMatch &result = m_searchResults.at(i);
+        cursor.setPosition(result.from);
+        cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, result.length());
         if (cursor.selectedText() != replacementText)
             cursor.insertText(replacementText);
     }
@@ -681,19 +744,10 @@ void TextDocumentSearch::doSearch(const QString &string)
     if (string.isEmpty())
         return;
 
-    QTextDocument *document = m_textDocument->textDocument();
-    QTextDocument::FindFlags flags;
-    flags &= int(m_searchFlags);
-
-    QTextCursor cursor(document);
-    while (1) {
-        cursor = document->find(string, cursor, flags);
-        if (cursor.isNull())
-            break;
-
-        m_searchResults << qMakePair<int, int>(cursor.selectionStart(), cursor.selectionEnd());
-        cursor.setPosition(cursor.selectionEnd());
-    }
+    // Searching the plain text with SearchEngine::matchesOf() keeps results in line with
+    // those of Screenplay::search(), whose per-scene result indexes refer to them.
+    const QString text = m_textDocument->textDocument()->toPlainText();
+    m_searchResults = SearchEngine::matchesOf(string, text, int(m_searchFlags));
 
     m_searchString = string;
     emit searchStringChanged();
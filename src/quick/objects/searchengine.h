@@ -15,6 +15,7 @@
 #define SEARCHENGINE_H
 
 #include <QObject>
+#include <QVector>
 #include <QJsonArray>
 #include <QQmlEngine>
 #include <QQuickTextDocument>
@@ -26,6 +27,20 @@
 
 class SearchEngine;
 
+/**
+ * A range of text matched by a search, with both ends inclusive. Searches collect these in
+ * a TextMatches vector, and convert them into JSON only when handing them over to QML.
+ */
+struct TextMatch
+{
+    int from = 0;
+    int to = -1;
+
+    int length() const { return to - from + 1; }
+};
+Q_DECLARE_TYPEINFO(TextMatch, Q_PRIMITIVE_TYPE);
+typedef QVector<TextMatch> TextMatches;
+
 class SearchAgent : public QObject
 {
     Q_OBJECT
@@ -93,7 +108,7 @@ private:
     int m_currentSearchResultIndex = -1;
     QObjectProperty<SearchEngine> m_engine;
     QObjectProperty<QQuickTextDocument> m_textDocument;
-    QList<QPair<int, int>> m_textDocumentSearchResults;
+    TextMatches m_textDocumentSearchResults;
 };
 
 class SearchEngine : public QObject
@@ -117,9 +132,11 @@ public:
     enum SearchFlag {
         SearchBackward = 0x00001,
         SearchCaseSensitively = 0x00002,
-        SearchWholeWords = 0x00004
+        SearchWholeWords = 0x00004,
+        SearchRegularExpression = 0x00008
     };
     Q_DECLARE_FLAGS(SearchFlags, SearchFlag)
+    Q_FLAG(SearchFlags)
     Q_PROPERTY(SearchFlags searchFlags READ searchFlags WRITE setSearchFlags NOTIFY searchFlagsChanged)
     void setSearchFlags(SearchFlags val);
     SearchFlags searchFlags() const { return m_searchFlags; }
@@ -133,6 +150,10 @@ public:
     void setIsSearchWholeWords(bool val) { m_searchFlags.setFlag(SearchWholeWords, val); }
     bool isIsSearchWholeWords() const { return m_searchFlags.testFlag(SearchWholeWords); }
 
+    Q_PROPERTY(bool isSearchRegularExpression READ isIsSearchRegularExpression WRITE setIsSearchRegularExpression NOTIFY searchFlagsChanged)
+    void setIsSearchRegularExpression(bool val) { m_searchFlags.setFlag(SearchRegularExpression, val); }
+    bool isIsSearchRegularExpression() const { return m_searchFlags.testFlag(SearchRegularExpression); }
+
     Q_PROPERTY(QString searchString READ searchString WRITE setSearchString NOTIFY searchStringChanged)
     void setSearchString(const QString &val);
     QString searchString() const { return m_searchString; }
@@ -154,7 +175,9 @@ public:
     Q_INVOKABLE void previousSearchResult();
     Q_INVOKABLE void cycleSearchResult();
 
+    static TextMatches matchesOf(const QString &of, const QString &in, int flags);
     static QJsonArray indexesOf(const QString &of, const QString &in, int flags);
+    static QJsonArray toJson(const TextMatches &matches);
     static QString createMarkupText(const QString &text, int from, int to, const QBrush &bg,
                                     const QBrush &fg);
 
@@ -239,7 +262,7 @@ private:
     QString m_searchString;
     int m_currentResultIndex = -1;
     SearchEngine::SearchFlags m_searchFlags;
-    QList<QPair<int, int>> m_searchResults;
+    TextMatches m_searchResults;
     QObjectProperty<QQuickTextDocument> m_textDocument;
 };
 
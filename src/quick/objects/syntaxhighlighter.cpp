@@ -167,7 +167,7 @@ class SyntaxHighlighterUserData : public QTextBlockUserData
 {
 public:
     explicit SyntaxHighlighterUserData() { }
-    ~SyntaxHighlighterUserData() { }
+    ~SyntaxHighlighterUserData() { qDeleteAll(m_userDataMap); }
 
     void setDelegateUserData(AbstractSyntaxHighlighterDelegate *delegate, QTextBlockUserData *data)
     {
@@ -427,6 +427,12 @@ void SyntaxHighlighter::documentContentsChanged()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+class LanguageFontSyntaxHighlighterUserData : public QTextBlockUserData
+{
+public:
+    TransliterationEngine::ScriptRunCache scriptRunCache;
+};
+
 LanguageFontSyntaxHighlighterDelegate::LanguageFontSyntaxHighlighterDelegate(QObject *parent)
     : AbstractSyntaxHighlighterDelegate(parent)
 {
@@ -475,16 +481,24 @@ void LanguageFontSyntaxHighlighterDelegate::highlightBlock(const QString &text)
         this->setFormat(0, block.length(), defaultFormat);
     }
 
-    const QList<TransliterationEngine::Boundary> boundaries =
-            TransliterationEngine::instance()->evaluateBoundaries(text);
+    LanguageFontSyntaxHighlighterUserData *userData =
+            this->currentBlockUserData<LanguageFontSyntaxHighlighterUserData>();
+    if (userData == nullptr) {
+        userData = new LanguageFontSyntaxHighlighterUserData;
+        this->setCurrentBlockUserData(userData);
+    }
+
+    const TransliterationEngine *engine = TransliterationEngine::instance();
+    const QVector<TransliterationEngine::ScriptRun> &runs =
+            userData->scriptRunCache.scriptRuns(text);
 
-    for (const TransliterationEngine::Boundary &boundary : boundaries) {
-        if (boundary.isEmpty() || boundary.language == TransliterationEngine::English)
+    for (const TransliterationEngine::ScriptRun &run : runs) {
+        if (run.language == TransliterationEngine::English)
             continue;
 
         QTextCharFormat format;
-        format.setFontFamily(boundary.font.family());
-        this->mergeFormat(boundary.start, boundary.end - boundary.start + 1, format);
+        format.setFontFamily(engine->languageFontFamily(run.language));
+        this->mergeFormat(run.start, run.length, format);
     }
 }
 
@@ -680,10 +694,11 @@ QStringList
 SpellCheckSyntaxHighlighterDelegate::spellingSuggestionsForWordAt(int cursorPosition) const
 {
     TextFragment fragment;
-    if (!this->findMisspelledTextFragment(cursorPosition, fragment))
+    QString misspelledWord;
+    if (!this->findMisspelledTextFragment(cursorPosition, fragment, &misspelledWord))
         return QStringList();
 
-    return fragment.suggestions();
+    return SpellCheckService::suggestions(misspelledWord);
 }
 
 void SpellCheckSyntaxHighlighterDelegate::replaceWordAt(int cursorPosition, const QString &with)
@@ -729,15 +744,25 @@ void SpellCheckSyntaxHighlighterDelegate::addWordAtPositionToIgnoreList(int curs
 void SpellCheckSyntaxHighlighterDelegate::checkForSpellingMistakeInCurrentWord()
 {
     TextFragment fragment;
-    if (m_cursorPosition >= 0 && this->findMisspelledTextFragment(m_cursorPosition, fragment)) {
+    QString misspelledWord;
+    if (m_cursorPosition >= 0
+        && this->findMisspelledTextFragment(m_cursorPosition, fragment, &misspelledWord)) {
         this->setWordUnderCursorIsMisspelled(true);
-        this->setSpellingSuggestionsForWordUnderCursor(fragment.suggestions());
+        this->lookupSpellingSuggestionsForWordUnderCursor(misspelledWord);
     } else {
         this->setWordUnderCursorIsMisspelled(false);
-        this->setSpellingSuggestionsForWordUnderCursor(QStringList());
+        this->lookupSpellingSuggestionsForWordUnderCursor(QString());
     }
 }
 
+void SpellCheckSyntaxHighlighterDelegate::lookupSpellingSuggestionsForWordUnderCursor(
+        const QString &word)
+{
+    m_spellingSuggestionsLookup.lookup(word, this, [=](const QStringList &suggestions) {
+        this->setSpellingSuggestionsForWordUnderCursor(suggestions);
+    });
+}
+
 void SpellCheckSyntaxHighlighterDelegate::highlightBlock(const QString &text)
 {
     const QTextBlock block = this->currentBlock();
@@ -793,7 +818,7 @@ void SpellCheckSyntaxHighlighterDelegate::setSpellingSuggestionsForWordUnderCurs
 }
 
 bool SpellCheckSyntaxHighlighterDelegate::findMisspelledTextFragment(
-        int cursorPosition, TextFragment &misspelledFragment) const
+        int cursorPosition, TextFragment &misspelledFragment, QString *misspelledWord) const
 {
     QTextCursor cursor(this->document());
     SpellCheckSyntaxHighlighterUserData *ud = nullptr;
@@ -810,6 +835,8 @@ bool SpellCheckSyntaxHighlighterDelegate::findMisspelledTextFragment(
     for (const TextFragment &fragment : mispelledFragments) {
         if (fragment.start() <= blockCursorPosition && fragment.end() >= blockCursorPosition) {
             misspelledFragment = fragment;
+            if (misspelledWord != nullptr)
+                *misspelledWord = block.text().mid(fragment.start(), fragment.length());
             return true;
         }
     }
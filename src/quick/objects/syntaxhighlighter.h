@@ -14,6 +14,8 @@
 #ifndef SYNTAXHIGHLIGHTER_H
 #define SYNTAXHIGHLIGHTER_H
 
+#include "spellcheckservice.h"
+
 #include <QQmlEngine>
 #include <QQmlParserStatus>
 #include <QSyntaxHighlighter>
@@ -283,7 +285,6 @@ private:
     QFont m_normal;
 };
 
-struct TextFragment;
 class SpellCheckSyntaxHighlighterUserData;
 class SpellCheckSyntaxHighlighterDelegate : public AbstractSyntaxHighlighterDelegate
 {
@@ -352,8 +353,10 @@ protected:
 private:
     void setWordUnderCursorIsMisspelled(bool val);
     void setSpellingSuggestionsForWordUnderCursor(const QStringList &val);
+    void lookupSpellingSuggestionsForWordUnderCursor(const QString &word);
 
-    bool findMisspelledTextFragment(int cursorPosition, TextFragment &misspelledFragment) const;
+    bool findMisspelledTextFragment(int cursorPosition, TextFragment &misspelledFragment,
+                                    QString *misspelledWord = nullptr) const;
     bool wordCursor(int cursorPosition, QTextCursor &cursor,
                     SpellCheckSyntaxHighlighterUserData *&ud) const;
 
@@ -363,6 +366,7 @@ private:
 
     int m_cursorPosition = -1;
     bool m_wordUnderCursorIsMisspelled = false;
+    SpellingSuggestionsLookup m_spellingSuggestionsLookup;
     QStringList m_spellingSuggestionsForWordUnderCursor;
 };
 
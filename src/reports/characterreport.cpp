@@ -15,6 +15,7 @@
 #include "deltadocument.h"
 #include "characterreport.h"
 #include "transliteration.h"
+#include "scenepresencematrix.h"
 
 #include <QTextTable>
 #include <QTextCursor>
@@ -393,6 +394,13 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
         cursor.insertBlock(blockFormat, charFormat);
         cursor.insertText("DETAIL:");
 
+        const ScenePresenceMatrix presence =
+                ScenePresenceMatrix::characters(screenplay->getElements(), m_characterNames);
+        auto isCharacterInScene = [&presence](int row, const QString &characterName) {
+            const int column = presence.indexOfName(characterName);
+            return column >= 0 && presence.isPresent(row, column);
+        };
+
         const int nrScenes = screenplay->elementCount();
         for (int i = 0; i < nrScenes; i++) {
             QTextTable *dialogueTable = nullptr;
@@ -407,7 +415,7 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
 
             bool sceneHasSaidCharacters = false;
             for (const QString &characterName : qAsConst(m_characterNames)) {
-                if (scene->characterNames().contains(characterName)) {
+                if (isCharacterInScene(i, characterName)) {
                     sceneCount[characterName] = sceneCount.value(characterName, 0) + 1;
 
                     if (sceneInfoWritten == false && m_includeSceneHeadings) {
@@ -522,7 +530,7 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
             QStringList muteCharacters;
             for (const QString &characterName : qAsConst(m_characterNames)) {
                 if (characterHasDialogue.value(characterName, false) == false
-                    && scene->characterNames().contains(characterName)) {
+                    && isCharacterInScene(i, characterName)) {
                     muteCharacters << characterName;
                 }
             }
@@ -12,6 +12,7 @@
 ****************************************************************************/
 
 #include "scenecharactermatrixreport.h"
+#include "scenepresencematrix.h"
 #include "transliteration.h"
 
 #include <QPrinter>
@@ -269,19 +270,19 @@ bool SceneCharacterMatrixReport::doGenerate(QTextDocument *document)
     }
 
     // Mark cells
+    const ScenePresenceMatrix presence =
+            ScenePresenceMatrix::characters(screenplayElements, m_characterNames);
     int sceneNumber = 0;
-    for (const ScreenplayElement *element : qAsConst(screenplayElements)) {
-        const Scene *scene = element->scene();
+    for (int i = 0; i < screenplayElements.size(); i++) {
+        const Scene *scene = screenplayElements.at(i)->scene();
         if (scene) {
-            const QStringList characters = scene->characterNames();
-            for (const QString &character : characters) {
-                const int row =
-                        m_type == SceneVsCharacter ? sceneNumber : rowHeadings.indexOf(character);
-                const int column = m_type == SceneVsCharacter ? columnHeadings.indexOf(character)
-                                                              : sceneNumber;
-                if (row < 0 || column < 0)
+            for (int c = 0; c < presence.columnCount(); c++) {
+                if (!presence.isPresent(i, c))
                     continue;
 
+                const int row = m_type == SceneVsCharacter ? sceneNumber : c;
+                const int column = m_type == SceneVsCharacter ? c : sceneNumber;
+
                 QTextTableCell cell = table->cellAt(row + 1, column + 1);
                 QTextBlockFormat cellFormat;
                 cellFormat.setBackground(Qt::black);
@@ -344,6 +345,9 @@ bool SceneCharacterMatrixReport::directExportToOdf(QIODevice *device)
     }
     ts << "\n";
 
+    const ScenePresenceMatrix presence =
+            ScenePresenceMatrix::characters(screenplayElements, m_characterNames);
+
     // Row contents
     const QString checkMark = m_marker.isEmpty() ? QStringLiteral("✓") : escapeComma(m_marker);
     for (int i = 0; i < nrRows; i++) {
@@ -362,18 +366,9 @@ bool SceneCharacterMatrixReport::directExportToOdf(QIODevice *device)
         for (int j = 0; j < nrCols; j++) {
             ts << ",";
 
-            Scene *scene = nullptr;
-            QString characterName;
-
-            if (m_type == SceneVsCharacter) {
-                scene = screenplayElements.at(i)->scene();
-                characterName = m_characterNames.at(j);
-            } else {
-                scene = screenplayElements.at(j)->scene();
-                characterName = m_characterNames.at(i);
-            }
-
-            if (scene->characterNames().contains(characterName))
+            const bool present = m_type == SceneVsCharacter ? presence.isPresent(i, j)
+                                                            : presence.isPresent(j, i);
+            if (present)
                 ts << checkMark;
         }
 
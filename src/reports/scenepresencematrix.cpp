@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "scenepresencematrix.h"
+#include "screenplay.h"
+#include "scene.h"
+
+ScenePresenceMatrix::ScenePresenceMatrix() { }
+
+ScenePresenceMatrix::~ScenePresenceMatrix() { }
+
+ScenePresenceMatrix ScenePresenceMatrix::characters(const QList<ScreenplayElement *> &elements,
+                                                    const QStringList &names)
+{
+    ScenePresenceMatrix ret;
+    ret.initialize(elements.size(), names);
+
+    for (int row = 0; row < elements.size(); row++) {
+        const Scene *scene = elements.at(row)->scene();
+        if (scene == nullptr)
+            continue;
+
+        scene->characterElementMap().forEachValue([&](const QString &name, int count) {
+            const int column = ret.m_columnMap.value(name, -1);
+            if (column >= 0)
+                ret.add(row, column, count);
+        });
+    }
+
+    return ret;
+}
+
+ScenePresenceMatrix ScenePresenceMatrix::locations(const QList<ScreenplayElement *> &elements,
+                                                   const QStringList &locations)
+{
+    ScenePresenceMatrix ret;
+    ret.initialize(elements.size(), locations);
+
+    QString lastLocation;
+    for (int row = 0; row < elements.size(); row++) {
+        const Scene *scene = elements.at(row)->scene();
+        if (scene == nullptr)
+            continue;
+
+        const QString sceneLocation =
+                scene->heading()->isEnabled() ? scene->heading()->location() : lastLocation;
+        lastLocation = sceneLocation;
+
+        const int column = ret.m_columnMap.value(sceneLocation.toUpper(), -1);
+        if (column >= 0)
+            ret.add(row, column, 1);
+    }
+
+    return ret;
+}
+
+void ScenePresenceMatrix::initialize(int rowCount, const QStringList &names)
+{
+    m_rowCount = rowCount;
+    m_names = names;
+
+    m_columnMap.clear();
+    m_columnMap.reserve(names.size());
+    for (int i = 0; i < names.size(); i++) {
+        const QString key = names.at(i).toUpper();
+        if (!m_columnMap.contains(key))
+            m_columnMap.insert(key, i);
+    }
+
+    m_counts = QVector<int>(rowCount * names.size(), 0);
+    m_totalCounts = QVector<int>(names.size(), 0);
+    m_rowsPresentIn = QVector<int>(names.size(), 0);
+}
+
+void ScenePresenceMatrix::add(int row, int column, int count)
+{
+    if (count <= 0)
+        return;
+
+    int &cell = m_counts[row * m_names.size() + column];
+    if (cell == 0)
+        ++m_rowsPresentIn[column];
+    cell += count;
+    m_totalCounts[column] += count;
+}
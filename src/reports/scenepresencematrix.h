@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef SCENEPRESENCEMATRIX_H
+#define SCENEPRESENCEMATRIX_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QStringList>
+
+class ScreenplayElement;
+
+/**
+ * Dense scene x name matrix, built in a single pass over the scenes. Each cell
+ * holds the number of times a name (character or location) occurs in a scene,
+ * with per-name totals computed up front. Reports look up presence in O(1)
+ * instead of querying each scene for each name.
+ *
+ * Rows follow the order of screenplay elements passed to the builder. Elements
+ * without a scene get a row of zeros.
+ */
+class ScenePresenceMatrix
+{
+public:
+    ScenePresenceMatrix();
+    ~ScenePresenceMatrix();
+
+    // Counts number of character elements of each name in each scene
+    static ScenePresenceMatrix characters(const QList<ScreenplayElement *> &elements,
+                                          const QStringList &names);
+
+    // Marks the location of each scene. Scenes without a heading are
+    // considered to be in the location of the scene before them.
+    static ScenePresenceMatrix locations(const QList<ScreenplayElement *> &elements,
+                                         const QStringList &locations);
+
+    int rowCount() const { return m_rowCount; }
+    int columnCount() const { return m_names.size(); }
+
+    QStringList names() const { return m_names; }
+    QString nameAt(int column) const { return m_names.at(column); }
+    int indexOfName(const QString &name) const { return m_columnMap.value(name.toUpper(), -1); }
+
+    int count(int row, int column) const { return m_counts.at(row * m_names.size() + column); }
+    bool isPresent(int row, int column) const { return this->count(row, column) > 0; }
+
+    // Sum of count() across all rows of a column
+    int totalCount(int column) const { return m_totalCounts.at(column); }
+
+    // Number of rows in which isPresent() returns true for a column
+    int rowsPresentIn(int column) const { return m_rowsPresentIn.at(column); }
+
+private:
+    void initialize(int rowCount, const QStringList &names);
+    void add(int row, int column, int count);
+
+private:
+    int m_rowCount = 0;
+    QStringList m_names;
+    QHash<QString, int> m_columnMap;
+    QVector<int> m_counts;
+    QVector<int> m_totalCounts;
+    QVector<int> m_rowsPresentIn;
+};
+
+#endif // SCENEPRESENCEMATRIX_H
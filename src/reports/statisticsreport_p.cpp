@@ -16,6 +16,7 @@
 
 #include "application.h"
 #include "screenplaytextdocument.h"
+#include "scenepresencematrix.h"
 
 #include <QPen>
 #include <QBrush>
@@ -924,11 +925,12 @@ StatisticsReportTimeline::evalCharacterPresence(const StatisticsReport *report)
     const QStringList characterNames =
             specificCharacterNames.isEmpty() ? allCharacterNames : specificCharacterNames;
 
+    const ScenePresenceMatrix matrix =
+            ScenePresenceMatrix::characters(this->presenceElements(report), characterNames);
     QList<QPair<QString, QList<int>>> ret = this->evalPresence(
-            report, characterNames, [](const Scene *scene, const QString &characterName) -> int {
-                return scene->hasCharacter(characterName)
-                        ? scene->characterPresence(characterName) + 2
-                        : 0;
+            matrix, [](const ScenePresenceMatrix &matrix, int row, int column) -> int {
+                const int count = matrix.count(row, column);
+                return count > 0 ? count + 2 : 0;
             });
     if (!specificCharacterNames.isEmpty())
         ret = ret.mid(0, specificCharacterNames.size());
@@ -946,14 +948,11 @@ StatisticsReportTimeline::evalLocationPresence(const StatisticsReport *report) c
     const QStringList specificLocations = report->locations();
     const QStringList locations = specificLocations.isEmpty() ? allLocations : specificLocations;
 
-    QString lastLocation;
+    const ScenePresenceMatrix matrix =
+            ScenePresenceMatrix::locations(this->presenceElements(report), locations);
     QList<QPair<QString, QList<int>>> ret = this->evalPresence(
-            report, locations, [&lastLocation](const Scene *scene, const QString &location) -> int {
-                const QString sceneLocation =
-                        scene->heading()->isEnabled() ? scene->heading()->location() : lastLocation;
-                const int ret = sceneLocation == location ? 10 : 0;
-                lastLocation = sceneLocation;
-                return ret;
+            matrix, [](const ScenePresenceMatrix &matrix, int row, int column) -> int {
+                return matrix.isPresent(row, column) ? 10 : 0;
             });
 
     if (!specificLocations.isEmpty())
@@ -965,33 +964,46 @@ StatisticsReportTimeline::evalLocationPresence(const StatisticsReport *report) c
 }
 
 QList<QPair<QString, QList<int>>> StatisticsReportTimeline::evalPresence(
-        const StatisticsReport *report, const QStringList &allNames,
-        std::function<int(const Scene *, const QString &)> determinePresenceFunc) const
+        const ScenePresenceMatrix &matrix,
+        std::function<int(const ScenePresenceMatrix &, int, int)> presenceValueFunc) const
 {
-    QList<QPair<QString, QList<int>>> ret;
-
-    const Screenplay *screenplay = report->document()->screenplay();
-    const QList<ScreenplayElement *> sceneElements = screenplay->getFilteredElements(
-            [](ScreenplayElement *e) { return e->scene() != nullptr && !e->isOmitted(); });
-
-    for (const QString &name : allNames)
-        ret << qMakePair(name, QList<int>());
+    struct Presence
+    {
+        QPair<QString, QList<int>> values;
+        int total = 0;
+    };
 
-    for (const auto sceneElement : sceneElements) {
-        auto scene = sceneElement->scene();
-        for (auto &pair : ret)
-            pair.second.append(determinePresenceFunc(scene, pair.first));
+    QVector<Presence> presence(matrix.columnCount());
+    for (int column = 0; column < matrix.columnCount(); column++) {
+        Presence &item = presence[column];
+        item.values.first = matrix.nameAt(column);
+        item.values.second.reserve(matrix.rowCount());
+        for (int row = 0; row < matrix.rowCount(); row++) {
+            const int value = presenceValueFunc(matrix, row, column);
+            item.values.second.append(value);
+            item.total += value;
+        }
     }
 
-    std::sort(ret.begin(), ret.end(),
-              [](const QPair<QString, QList<int>> &a, const QPair<QString, QList<int>> &b) {
-                  return std::accumulate(a.second.begin(), a.second.end(), 0)
-                          > std::accumulate(b.second.begin(), b.second.end(), 0);
-              });
+    std::stable_sort(presence.begin(), presence.end(),
+                     [](const Presence &a, const Presence &b) { return a.total > b.total; });
+
+    QList<QPair<QString, QList<int>>> ret;
+    ret.reserve(presence.size());
+    for (const Presence &item : qAsConst(presence))
+        ret.append(item.values);
 
     return ret;
 }
 
+QList<ScreenplayElement *>
+StatisticsReportTimeline::presenceElements(const StatisticsReport *report) const
+{
+    const Screenplay *screenplay = report->document()->screenplay();
+    return screenplay->getFilteredElements(
+            [](ScreenplayElement *e) { return e->scene() != nullptr && !e->isOmitted(); });
+}
+
 QGraphicsRectItem *StatisticsReportTimeline::createCharacterPresenceGraph(
         const StatisticsReport *report, QGraphicsItem *container,
         const QGraphicsRectItem *sceneItemsContainer) const
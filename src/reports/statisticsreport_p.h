@@ -18,6 +18,8 @@
 #include "statisticsreport.h"
 
 class Screenplay;
+class ScreenplayElement;
+class ScenePresenceMatrix;
 class StatisticsReport;
 class ScreenplayTextDocument;
 
@@ -61,8 +63,9 @@ private:
     QList<QPair<QString, QList<int>>> evalCharacterPresence(const StatisticsReport *report) const;
     QList<QPair<QString, QList<int>>> evalLocationPresence(const StatisticsReport *report) const;
     QList<QPair<QString, QList<int>>>
-    evalPresence(const StatisticsReport *report, const QStringList &allNames,
-                 std::function<int(const Scene *, const QString &)> determinePresenceFunc) const;
+    evalPresence(const ScenePresenceMatrix &matrix,
+                 std::function<int(const ScenePresenceMatrix &, int, int)> presenceValueFunc) const;
+    QList<ScreenplayElement *> presenceElements(const StatisticsReport *report) const;
 
     QGraphicsRectItem *
     createCharacterPresenceGraph(const StatisticsReport *report, QGraphicsItem *container,
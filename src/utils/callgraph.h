@@ -14,7 +14,19 @@
 #ifndef CALLGRAPH_H
 #define CALLGRAPH_H
 
-#define CAPTURE_CALL_GRAPH
-#define CAPTURE_FIRST_CALL_GRAPH
+#include "timeprofiler.h"
+
+// Without the external profiling tools, call graphs are approximated by the
+// nesting of scoped events in the trace captured by TimeProfiler.
+#define CAPTURE_CALL_GRAPH                                                                         \
+    static TimeProfilerSite callGraphSite(Q_FUNC_INFO);                                            \
+    TimeProfilerScope callGraphScope(&callGraphSite)
+
+#define CAPTURE_FIRST_CALL_GRAPH                                                                   \
+    static std::atomic<bool> callGraphCaptured(false);                                             \
+    static TimeProfilerSite firstCallGraphSite(Q_FUNC_INFO);                                       \
+    TimeProfilerScope firstCallGraphScope(                                                         \
+            TimeProfiler::isEnabled() && !callGraphCaptured.exchange(true) ? &firstCallGraphSite   \
+                                                                    : nullptr)
 
 #endif // CALLGRAPH_H
@@ -20,35 +20,216 @@
 #include <QLineF>
 #include <QTransform>
 #include <QElapsedTimer>
+#include <QVarLengthArray>
+#include <QtConcurrentMap>
+
+#include <numeric>
 
 using namespace GraphLayout;
 
 static const qreal fdg_constant = 0.0001;
 
+// In AutomaticRepulsion mode, graphs with at least these many nodes use Barnes-Hut
+static const int fdg_barnesHutThreshold = 64;
+
+// Forces are accumulated in parallel only if there is enough work to go around
+static const int fdg_parallelThreshold = 256;
+
+namespace {
+
+/**
+ * Quadtree over node positions, built afresh in each iteration. Every cell
+ * keeps track of the number of nodes (mass) within it and the sum of their
+ * positions, from which we get the center of mass.
+ */
+class ForceDirectedQuadTree
+{
+public:
+    explicit ForceDirectedQuadTree(const QVector<QPointF> &positions);
+
+    QPointF repulsion(int body, qreal theta, qreal k) const;
+
+private:
+    enum { MaxDepth = 32 };
+
+    struct Cell
+    {
+        QPointF center;
+        qreal halfSize = 0;
+        QPointF positionSum;
+        int mass = 0;
+        int body = -1;
+        int children[4] = { -1, -1, -1, -1 };
+        bool hasChildren = false;
+    };
+
+    void insert(int cellIndex, int body, int depth);
+    int child(int cellIndex, const QPointF &pos);
+
+private:
+    const QVector<QPointF> &m_positions;
+    QVector<Cell> m_cells;
+};
+
+ForceDirectedQuadTree::ForceDirectedQuadTree(const QVector<QPointF> &positions)
+    : m_positions(positions)
+{
+    if (positions.isEmpty())
+        return;
+
+    qreal minX = positions.first().x(), maxX = minX;
+    qreal minY = positions.first().y(), maxY = minY;
+    for (const QPointF &pos : positions) {
+        minX = qMin(minX, pos.x());
+        maxX = qMax(maxX, pos.x());
+        minY = qMin(minY, pos.y());
+        maxY = qMax(maxY, pos.y());
+    }
+
+    Cell root;
+    root.center = QPointF((minX + maxX) / 2.0, (minY + maxY) / 2.0);
+    root.halfSize = qMax(maxX - minX, maxY - minY) / 2.0 + 1e-6;
+
+    m_cells.reserve(positions.size() * 2);
+    m_cells.append(root);
+
+    for (int i = 0; i < positions.size(); i++)
+        this->insert(0, i, 0);
+}
+
+QPointF ForceDirectedQuadTree::repulsion(int body, qreal theta, qreal k) const
+{
+    QPointF force(0, 0);
+    if (m_cells.isEmpty())
+        return force;
+
+    const QPointF pos = m_positions.at(body);
+
+    QVarLengthArray<int, 128> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Cell &cell = m_cells.at(stack.takeLast());
+        if (cell.mass == 0 || (!cell.hasChildren && cell.body == body && cell.mass == 1))
+            continue;
+
+        const QPointF dp = cell.positionSum / qreal(cell.mass) - pos;
+        const qreal d2 = dp.x() * dp.x() + dp.y() * dp.y();
+
+        // A far enough cell (size/distance < theta) acts as one body at its
+        // center of mass.
+        const qreal size = 2.0 * cell.halfSize;
+        if (!cell.hasChildren || size * size < theta * theta * d2) {
+            if (!qFuzzyIsNull(d2))
+                force -= dp * (k * cell.mass / d2);
+            continue;
+        }
+
+        for (int c : cell.children) {
+            if (c >= 0)
+                stack.append(c);
+        }
+    }
+
+    return force;
+}
+
+void ForceDirectedQuadTree::insert(int cellIndex, int body, int depth)
+{
+    const QPointF pos = m_positions.at(body);
+
+    // Note: m_cells may get reallocated in child(), so we dont hold references
+    // to cells across those calls.
+    while (true) {
+        Cell &cell = m_cells[cellIndex];
+        ++cell.mass;
+        cell.positionSum += pos;
+
+        if (!cell.hasChildren) {
+            if (cell.mass == 1) {
+                cell.body = body;
+                return;
+            }
+
+            // Coincident (or nearly so) nodes simply accumulate in the leaf.
+            if (depth >= MaxDepth)
+                return;
+
+            const int existingBody = cell.body;
+            cell.body = -1;
+            cell.hasChildren = true;
+
+            const QPointF existingPos = m_positions.at(existingBody);
+            Cell &existingChild = m_cells[this->child(cellIndex, existingPos)];
+            existingChild.mass = 1;
+            existingChild.positionSum = existingPos;
+            existingChild.body = existingBody;
+        }
+
+        cellIndex = this->child(cellIndex, pos);
+        ++depth;
+    }
+}
+
+int ForceDirectedQuadTree::child(int cellIndex, const QPointF &pos)
+{
+    const Cell cell = m_cells.at(cellIndex);
+    const int quadrant =
+            (pos.x() >= cell.center.x() ? 1 : 0) + (pos.y() >= cell.center.y() ? 2 : 0);
+    if (cell.children[quadrant] >= 0)
+        return cell.children[quadrant];
+
+    const qreal quarterSize = cell.halfSize / 2.0;
+
+    Cell newCell;
+    newCell.halfSize = quarterSize;
+    newCell.center = cell.center
+            + QPointF(quadrant & 1 ? quarterSize : -quarterSize,
+                      quadrant & 2 ? quarterSize : -quarterSize);
+
+    const int ret = m_cells.size();
+    m_cells.append(newCell);
+    m_cells[cellIndex].children[quadrant] = ret;
+    return ret;
+}
+
+}
+
 ForceDirectedLayout::ForceDirectedLayout() { }
 
 ForceDirectedLayout::~ForceDirectedLayout() { }
 
 bool ForceDirectedLayout::layout(const Graph &graph)
 {
+    PROFILE_THIS_FUNCTION;
+
     // Sanity checks
     if (graph.nodes.isEmpty() || graph.edges.isEmpty())
         return false;
 
+    const int nrNodes = graph.nodes.size();
+
+    QHash<AbstractNode *, int> nodeIndexMap;
+    nodeIndexMap.reserve(nrNodes);
+    for (int i = 0; i < nrNodes; i++)
+        nodeIndexMap.insert(graph.nodes.at(i), i);
+
     // If the graph contains nodes that are not part of edges within it,
     // then we must not even bother laying it out.
-    QHash<AbstractNode *, int> refCountMap;
+    QVector<int> refCounts(nrNodes, 0);
+    QVector<QPair<int, int>> edges;
+    edges.reserve(graph.edges.size());
     for (AbstractEdge *edge : qAsConst(graph.edges)) {
-        const int i1 = graph.nodes.indexOf(edge->node1());
-        const int i2 = graph.nodes.indexOf(edge->node2());
+        const int i1 = nodeIndexMap.value(edge->node1(), -1);
+        const int i2 = nodeIndexMap.value(edge->node2(), -1);
         if (i1 < 0 || i2 < 0)
             return false;
-        refCountMap[edge->node1()]++;
-        refCountMap[edge->node2()]++;
+        refCounts[i1]++;
+        refCounts[i2]++;
+        edges.append(qMakePair(i1, i2));
     }
 
-    for (AbstractNode *node : qAsConst(graph.nodes)) {
-        if (refCountMap.value(node, 0) == 0)
+    for (int refCount : qAsConst(refCounts)) {
+        if (refCount == 0)
             return false;
     }
 
@@ -56,13 +237,15 @@ bool ForceDirectedLayout::layout(const Graph &graph)
     // to each other with edges. No zombie nodes and no edges that connect to nodes
     // outside the given graph.
 
-    // Place the nodes in a circle and figure out maximum size of nodes
-    const qreal angleStep = 2 * M_PI / qreal(graph.nodes.size());
+    // Place the nodes in a circle and figure out maximum size of nodes. While
+    // iterating we only work with positions, nodes are moved once at the end.
+    const qreal angleStep = 2 * M_PI / qreal(nrNodes);
+    QVector<QPointF> positions(nrNodes);
     QSizeF maxSize(0, 0);
     qreal angle = 0;
-    for (AbstractNode *node : qAsConst(graph.nodes)) {
-        if (node->canBeMoved())
-            node->setPosition(QPointF(qCos(angle), qSin(angle)));
+    for (int i = 0; i < nrNodes; i++) {
+        const AbstractNode *node = graph.nodes.at(i);
+        positions[i] = node->canBeMoved() ? QPointF(qCos(angle), qSin(angle)) : node->position();
 
         angle += angleStep;
 
@@ -71,17 +254,24 @@ bool ForceDirectedLayout::layout(const Graph &graph)
         maxSize.setHeight(qMax(nodeSize.height(), maxSize.height()));
     }
 
+    const bool useBarnesHut = m_repulsionMode == BarnesHutRepulsion
+            || (m_repulsionMode == AutomaticRepulsion && nrNodes >= fdg_barnesHutThreshold);
+
     // Perform force directed graph layout
     int nrIterations = 0;
 
     QElapsedTimer timer;
     timer.start();
 
+    QVector<QPointF> forces(nrNodes);
     while (timer.elapsed() < this->maxTime()) {
-        QVector<QPointF> forces(graph.nodes.size(), QPointF(0, 0));
-        calculateRepulsion(forces, graph);
-        calculateAttraction(forces, graph);
-        bool moved = placeNodes(forces, graph);
+        forces.fill(QPointF(0, 0));
+        if (useBarnesHut)
+            calculateBarnesHutRepulsion(forces, positions);
+        else
+            calculateRepulsion(forces, positions);
+        calculateAttraction(forces, positions, edges);
+        bool moved = placeNodes(forces, positions);
 
         ++nrIterations;
         if (!moved || (maxIterations() > 0 && nrIterations >= maxIterations()))
@@ -97,22 +287,21 @@ bool ForceDirectedLayout::layout(const Graph &graph)
 
     // Now, lets find out the least space between any two nodes in the layed out
     // graph.
-    qreal minNodeSpacing = 240000.0;
-    for (AbstractNode *n1 : qAsConst(graph.nodes)) {
-        for (AbstractNode *n2 : qAsConst(graph.nodes)) {
-            if (n1 == n2)
-                continue;
-            const qreal nodeSpacing = QLineF(n1->position(), n2->position()).length();
-            minNodeSpacing = qMin(nodeSpacing, minNodeSpacing);
+    qreal minNodeSpacing2 = 240000.0 * 240000.0;
+    for (int i = 0; i < nrNodes - 1; i++) {
+        const QPointF p1 = positions.at(i);
+        for (int j = i + 1; j < nrNodes; j++) {
+            const QPointF dp = positions.at(j) - p1;
+            minNodeSpacing2 = qMin(dp.x() * dp.x() + dp.y() * dp.y(), minNodeSpacing2);
         }
     }
 
     // Compute the scaling factor based on the above.
-    const qreal scale = minNodeSpacingPx / minNodeSpacing;
+    const qreal scale = minNodeSpacingPx / qSqrt(minNodeSpacing2);
 
     // Apply the scaling
-    for (AbstractNode *node : qAsConst(graph.nodes))
-        node->setPosition(node->position() * scale);
+    for (int i = 0; i < nrNodes; i++)
+        graph.nodes.at(i)->setPosition(positions.at(i) * scale);
 
     // Get the edges to compute their paths
     for (AbstractEdge *edge : qAsConst(graph.edges))
@@ -121,51 +310,74 @@ bool ForceDirectedLayout::layout(const Graph &graph)
     return true;
 }
 
-void ForceDirectedLayout::calculateRepulsion(QVector<QPointF> &forces, const Graph &graph)
+void ForceDirectedLayout::calculateRepulsion(QVector<QPointF> &forces,
+                                             const QVector<QPointF> &positions) const
 {
+    // Force of magnitude k/d along the unit vector dp/d, which is k*dp/d^2.
     const qreal k = fdg_constant;
-    for (int i = 0; i <= graph.nodes.size() - 2; i++) {
-        for (int j = i + 1; j <= graph.nodes.size() - 1; j++) {
-            const AbstractNode *n1 = graph.nodes.at(i);
-            const AbstractNode *n2 = graph.nodes.at(j);
-            const QPointF dp = n2->position() - n1->position();
-            const qreal force = k / qSqrt((qPow(dp.x(), 2.0) + qPow(dp.y(), 2.0)));
-            const qreal angle = qAtan2(dp.y(), dp.x());
-            const QPointF delta(force * qCos(angle), force * qSin(angle));
+    for (int i = 0; i <= positions.size() - 2; i++) {
+        for (int j = i + 1; j <= positions.size() - 1; j++) {
+            const QPointF dp = positions.at(j) - positions.at(i);
+            const qreal d2 = dp.x() * dp.x() + dp.y() * dp.y();
+            if (qFuzzyIsNull(d2))
+                continue;
+            const QPointF delta = dp * (k / d2);
             forces[i] -= delta;
             forces[j] += delta;
         }
     }
 }
 
-void ForceDirectedLayout::calculateAttraction(QVector<QPointF> &forces, const Graph &graph)
+void ForceDirectedLayout::calculateBarnesHutRepulsion(QVector<QPointF> &forces,
+                                                      const QVector<QPointF> &positions) const
+{
+    const qreal k = fdg_constant;
+    const qreal theta = m_barnesHutTheta;
+    const ForceDirectedQuadTree tree(positions);
+
+    // Each node only ever writes into its own slot, so there is nothing to
+    // synchronize when this is done in parallel.
+    QPointF *forceData = forces.data();
+    if (m_parallelForces && positions.size() >= fdg_parallelThreshold) {
+        QVector<int> bodies(positions.size());
+        std::iota(bodies.begin(), bodies.end(), 0);
+        QtConcurrent::blockingMap(bodies, [&](const int &body) {
+            forceData[body] += tree.repulsion(body, theta, k);
+        });
+        return;
+    }
+
+    for (int i = 0; i < positions.size(); i++)
+        forceData[i] += tree.repulsion(i, theta, k);
+}
+
+void ForceDirectedLayout::calculateAttraction(QVector<QPointF> &forces,
+                                              const QVector<QPointF> &positions,
+                                              const QVector<QPair<int, int>> &edges) const
 {
+    // Force of magnitude k*d^2 along the unit vector dp/d, which is k*d*dp.
     const qreal k = fdg_constant;
-    for (AbstractEdge *edge : graph.edges) {
-        AbstractNode *n1 = edge->node1();
-        AbstractNode *n2 = edge->node2();
-        const QPointF dp = n2->position() - n1->position();
-        const int i = graph.nodes.indexOf(n1);
-        const int j = graph.nodes.indexOf(n2);
-        const qreal force = k * (qPow(dp.x(), 2.0) + qPow(dp.y(), 2.0));
-        const qreal angle = qAtan2(dp.y(), dp.x());
-        const QPointF delta(force * qCos(angle), force * qSin(angle));
+    for (const QPair<int, int> &edge : edges) {
+        const int i = edge.first;
+        const int j = edge.second;
+        const QPointF dp = positions.at(j) - positions.at(i);
+        const qreal d = qSqrt(dp.x() * dp.x() + dp.y() * dp.y());
+        const QPointF delta = dp * (k * d);
         forces[i] += delta;
         forces[j] -= delta;
     }
 }
 
-bool ForceDirectedLayout::placeNodes(const QVector<QPointF> &forces, const Graph &graph)
+bool ForceDirectedLayout::placeNodes(const QVector<QPointF> &forces,
+                                     QVector<QPointF> &positions) const
 {
     bool moved = false;
-    for (int i = 0; i < graph.nodes.size(); i++) {
-        AbstractNode *node = graph.nodes.at(i);
+    for (int i = 0; i < positions.size(); i++) {
         const QPointF force = forces.at(i);
         if (qFuzzyIsNull(force.x()) && qFuzzyIsNull(force.y()))
             continue;
 
-        const QPointF pos = node->position() + force;
-        node->setPosition(pos);
+        positions[i] += force;
         moved = true;
     }
 
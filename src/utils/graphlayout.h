@@ -14,6 +14,7 @@
 #ifndef GRAPHLAYOUT_H
 #define GRAPHLAYOUT_H
 
+#include <QPair>
 #include <QSizeF>
 #include <QPointF>
 #include <QVector>
@@ -90,13 +91,37 @@ public:
     explicit ForceDirectedLayout();
     ~ForceDirectedLayout();
 
+    // Repulsion between every pair of nodes is O(n^2) per iteration. For large
+    // graphs we approximate it using a Barnes-Hut quadtree, which is O(n log n).
+    // https://en.wikipedia.org/wiki/Barnes%E2%80%93Hut_simulation
+    enum RepulsionMode { ExactRepulsion, BarnesHutRepulsion, AutomaticRepulsion };
+    void setRepulsionMode(RepulsionMode val) { m_repulsionMode = val; }
+    RepulsionMode repulsionMode() const { return m_repulsionMode; }
+
+    // Ratio of cell-size to distance below which a quadtree cell is treated as a
+    // single body. Smaller values are more accurate, but slower.
+    void setBarnesHutTheta(qreal val) { m_barnesHutTheta = qMax(val, 0.0); }
+    qreal barnesHutTheta() const { return m_barnesHutTheta; }
+
+    // When set, repulsive forces on large graphs are accumulated using all cores.
+    void setParallelForces(bool val) { m_parallelForces = val; }
+    bool isParallelForces() const { return m_parallelForces; }
+
     // AbstractGraphLayout interface
     bool layout(const Graph &graph);
 
 private:
-    void calculateRepulsion(QVector<QPointF> &forces, const Graph &graph);
-    void calculateAttraction(QVector<QPointF> &forces, const Graph &graph);
-    bool placeNodes(const QVector<QPointF> &forces, const Graph &graph);
+    void calculateRepulsion(QVector<QPointF> &forces, const QVector<QPointF> &positions) const;
+    void calculateBarnesHutRepulsion(QVector<QPointF> &forces,
+                                     const QVector<QPointF> &positions) const;
+    void calculateAttraction(QVector<QPointF> &forces, const QVector<QPointF> &positions,
+                             const QVector<QPair<int, int>> &edges) const;
+    bool placeNodes(const QVector<QPointF> &forces, QVector<QPointF> &positions) const;
+
+private:
+    RepulsionMode m_repulsionMode = AutomaticRepulsion;
+    qreal m_barnesHutTheta = 0.5;
+    bool m_parallelForces = false;
 };
 
 }
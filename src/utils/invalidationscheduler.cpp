@@ -0,0 +1,290 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "invalidationscheduler.h"
+#include "timeprofiler.h"
+
+#include <QThread>
+#include <QThreadStorage>
+
+#include <algorithm>
+
+Invalidatable::~Invalidatable()
+{
+    if (m_nrPendingInvalidations > 0) {
+        InvalidationScheduler *scheduler = InvalidationScheduler::instance(false);
+        if (scheduler != nullptr)
+            scheduler->cancelAll(this);
+    }
+}
+
+void Invalidatable::invalidateLater(int key, int delay)
+{
+    InvalidationScheduler::instance()->schedule(this, key, delay);
+}
+
+void Invalidatable::cancelInvalidation(int key)
+{
+    if (m_nrPendingInvalidations > 0)
+        InvalidationScheduler::instance()->cancel(this, key);
+}
+
+bool Invalidatable::isInvalidationPending(int key) const
+{
+    if (m_nrPendingInvalidations == 0)
+        return false;
+
+    const InvalidationScheduler *scheduler = InvalidationScheduler::instance(false);
+    return scheduler != nullptr && scheduler->isScheduled(this, key);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Q_GLOBAL_STATIC(QThreadStorage<InvalidationScheduler *>, ThreadSchedulers)
+
+InvalidationScheduler *InvalidationScheduler::instance(bool create)
+{
+    if (ThreadSchedulers.isDestroyed())
+        return nullptr;
+
+    if (!ThreadSchedulers->hasLocalData()) {
+        if (!create)
+            return nullptr;
+        ThreadSchedulers->setLocalData(new InvalidationScheduler);
+    }
+
+    return ThreadSchedulers->localData();
+}
+
+InvalidationScheduler::InvalidationScheduler(QObject *parent) : QObject(parent)
+{
+    m_clock.start();
+
+    m_timer.setObjectName(QStringLiteral("InvalidationScheduler"));
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::CoarseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &InvalidationScheduler::onTimeout);
+}
+
+InvalidationScheduler::~InvalidationScheduler()
+{
+    // Objects that outlive the scheduler must not try to cancel anything.
+    for (const QHash<Invalidatable *, Entries> &stage : m_pending) {
+        for (auto it = stage.begin(); it != stage.end(); ++it)
+            it.key()->m_nrPendingInvalidations = 0;
+    }
+}
+
+void InvalidationScheduler::schedule(Invalidatable *target, int key, int delay)
+{
+    if (target == nullptr)
+        return;
+
+    const qint64 due = m_clock.elapsed() + qMax(delay, 0);
+
+    Entries &entries = m_pending[target->m_invalidationStage][target];
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [key](const Entry &e) { return e.key == key; });
+    if (it != entries.end()) {
+        ++it->requestCount;
+        it->due = due;
+    } else {
+        Entry entry;
+        entry.key = key;
+        entry.requestCount = 1;
+        entry.due = due;
+        entries.append(entry);
+        ++target->m_nrPendingInvalidations;
+    }
+
+    this->restartTimer(due);
+}
+
+void InvalidationScheduler::cancel(Invalidatable *target, int key)
+{
+    if (target == nullptr)
+        return;
+
+    QHash<Invalidatable *, Entries> &stage = m_pending[target->m_invalidationStage];
+    auto it = stage.find(target);
+    if (it == stage.end())
+        return;
+
+    Entries &entries = it.value();
+    for (int i = entries.size() - 1; i >= 0; i--) {
+        if (entries.at(i).key == key) {
+            entries.remove(i);
+            --target->m_nrPendingInvalidations;
+        }
+    }
+
+    if (entries.isEmpty())
+        stage.erase(it);
+
+    for (Batch *batch : qAsConst(m_activeBatches)) {
+        for (QPair<Invalidatable *, int> &item : *batch) {
+            if (item.first == target && item.second == key) {
+                item.first = nullptr;
+                --target->m_nrPendingInvalidations;
+            }
+        }
+    }
+}
+
+void InvalidationScheduler::cancelAll(Invalidatable *target)
+{
+    if (target == nullptr)
+        return;
+
+    m_pending[target->m_invalidationStage].remove(target);
+
+    for (Batch *batch : qAsConst(m_activeBatches)) {
+        for (QPair<Invalidatable *, int> &item : *batch) {
+            if (item.first == target)
+                item.first = nullptr;
+        }
+    }
+
+    target->m_nrPendingInvalidations = 0;
+}
+
+bool InvalidationScheduler::isScheduled(const Invalidatable *target, int key) const
+{
+    if (target == nullptr)
+        return false;
+
+    const Entries entries = m_pending[target->m_invalidationStage].value(
+            const_cast<Invalidatable *>(target));
+    return std::any_of(entries.begin(), entries.end(),
+                       [key](const Entry &e) { return e.key == key; });
+}
+
+bool InvalidationScheduler::hasPendingInvalidations() const
+{
+    for (const QHash<Invalidatable *, Entries> &stage : m_pending) {
+        if (!stage.isEmpty())
+            return true;
+    }
+
+    return false;
+}
+
+void InvalidationScheduler::flushCurrentThread()
+{
+    InvalidationScheduler *scheduler = InvalidationScheduler::instance(false);
+    if (scheduler != nullptr)
+        scheduler->flush();
+}
+
+void InvalidationScheduler::onTimeout()
+{
+    m_timerDue = -1;
+    this->flushPending(false);
+}
+
+void InvalidationScheduler::flushPending(bool all)
+{
+    PROFILE_THIS_FUNCTION;
+
+    int nrRequests = 0;
+    int nrInvalidations = 0;
+
+    // Flushing an element may invalidate its scene, which may in turn invalidate
+    // the screenplay. Such follow up work, if already due, is picked up in the
+    // next round of the same flush. The cap on rounds guards against objects
+    // that keep invalidating themselves.
+    const int maxRounds = 16;
+    for (int round = 0; round < maxRounds; round++) {
+        const qint64 now = m_clock.elapsed();
+        bool flushedSomething = false;
+
+        for (QHash<Invalidatable *, Entries> &stage : m_pending) {
+            Batch batch;
+            for (auto it = stage.begin(); it != stage.end();) {
+                Entries &entries = it.value();
+                for (int i = entries.size() - 1; i >= 0; i--) {
+                    const Entry &entry = entries.at(i);
+                    if (all || entry.due <= now) {
+                        batch.append(qMakePair(it.key(), entry.key));
+                        nrRequests += entry.requestCount;
+                        entries.remove(i);
+                    }
+                }
+
+                if (entries.isEmpty())
+                    it = stage.erase(it);
+                else
+                    ++it;
+            }
+
+            if (batch.isEmpty())
+                continue;
+
+            flushedSomething = true;
+
+            // Targets may get destroyed, or may cancel invalidations, while we are
+            // going through the batch. Those calls null out entries in the batch that
+            // are yet to run. Entries that have run are nulled out here, so that they
+            // are not accounted for twice.
+            m_activeBatches.append(&batch);
+            for (int i = 0; i < batch.size(); i++) {
+                Invalidatable *target = batch.at(i).first;
+                if (target == nullptr)
+                    continue;
+
+                batch[i].first = nullptr;
+                --target->m_nrPendingInvalidations;
+                target->flushInvalidation(batch.at(i).second);
+                ++nrInvalidations;
+            }
+            m_activeBatches.removeOne(&batch);
+        }
+
+        if (!flushedSomething)
+            break;
+    }
+
+    if (nrRequests > 0) {
+        ++m_statistics.flushCount;
+        m_statistics.requestCount += nrRequests;
+        m_statistics.invalidationCount += nrInvalidations;
+        m_statistics.lastFlushRequestCount = nrRequests;
+        m_statistics.lastFlushInvalidationCount = nrInvalidations;
+    }
+
+    // Schedule the next tick for whatever is still pending
+    qint64 nextDue = -1;
+    for (const QHash<Invalidatable *, Entries> &stage : m_pending) {
+        for (auto it = stage.begin(); it != stage.end(); ++it) {
+            for (const Entry &entry : it.value())
+                nextDue = nextDue < 0 ? entry.due : qMin(nextDue, entry.due);
+        }
+    }
+
+    m_timer.stop();
+    m_timerDue = -1;
+    if (nextDue >= 0)
+        this->restartTimer(nextDue);
+}
+
+void InvalidationScheduler::restartTimer(qint64 due)
+{
+    if (m_timerDue >= 0 && m_timerDue <= due && m_timer.isActive())
+        return;
+
+    if (this->thread()->eventDispatcher() == nullptr)
+        return;
+
+    m_timerDue = due;
+    m_timer.start(int(qMax(due - m_clock.elapsed(), qint64(0))));
+}
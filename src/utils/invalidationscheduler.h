@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef INVALIDATIONSCHEDULER_H
+#define INVALIDATIONSCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+
+/**
+ * Objects that need to do some work "later" derive from this class, instead of
+ * owning a timer for each kind of deferred work. Invalidations are identified
+ * by a key, which is private to the class deriving from Invalidatable.
+ * Invalidating the same key several times before it is flushed results in
+ * exactly one call to flushInvalidation().
+ */
+class Invalidatable
+{
+public:
+    // Stages are flushed in this order, so that element level work is done
+    // before scene level work, which in turn is done before screenplay level work.
+    enum Stage { ElementStage, SceneStage, ScreenplayStage, StageCount };
+
+    explicit Invalidatable(Stage stage) : m_invalidationStage(stage) { }
+    virtual ~Invalidatable();
+
+    Stage invalidationStage() const { return m_invalidationStage; }
+
+protected:
+    // Like QBasicTimer::start(), each call pushes the deadline to delay
+    // milliseconds from now.
+    void invalidateLater(int key, int delay = 0);
+    void cancelInvalidation(int key);
+    bool isInvalidationPending(int key) const;
+
+    virtual void flushInvalidation(int key) = 0;
+
+private:
+    friend class InvalidationScheduler;
+    const Stage m_invalidationStage;
+    int m_nrPendingInvalidations = 0;
+};
+
+class InvalidationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // There is one scheduler per thread. Invalidatable objects are serviced by
+    // the scheduler of the thread in which they invalidate keys.
+    static InvalidationScheduler *instance(bool create = true);
+    ~InvalidationScheduler();
+
+    void schedule(Invalidatable *target, int key, int delay = 0);
+    void cancel(Invalidatable *target, int key);
+    void cancelAll(Invalidatable *target);
+    bool isScheduled(const Invalidatable *target, int key) const;
+    bool hasPendingInvalidations() const;
+
+    // Flushes all pending invalidations right away, whether they are due or
+    // not. This is useful when documents are processed without an event loop,
+    // for instance while exporting from the command line.
+    void flush() { this->flushPending(true); }
+
+    // Flushes the scheduler of the calling thread, if it has one. Exporters and
+    // report generators call this before writing, so that deferred evaluations
+    // (word counts, scene numbers etc.) are complete even without an event loop.
+    static void flushCurrentThread();
+
+    struct Statistics
+    {
+        qint64 flushCount = 0;
+        qint64 requestCount = 0; // calls to schedule() that got flushed
+        qint64 invalidationCount = 0; // calls to flushInvalidation()
+        int lastFlushRequestCount = 0;
+        int lastFlushInvalidationCount = 0;
+
+        qint64 coalescedCount() const { return requestCount - invalidationCount; }
+        int lastFlushCoalescedCount() const
+        {
+            return lastFlushRequestCount - lastFlushInvalidationCount;
+        }
+    };
+    Statistics statistics() const { return m_statistics; }
+
+private:
+    explicit InvalidationScheduler(QObject *parent = nullptr);
+    void onTimeout();
+    void flushPending(bool all);
+    void restartTimer(qint64 due);
+
+private:
+    struct Entry
+    {
+        int key = 0;
+        int requestCount = 0;
+        qint64 due = 0;
+    };
+    using Entries = QVarLengthArray<Entry, 4>;
+    using Batch = QVector<QPair<Invalidatable *, int>>;
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_timerDue = -1;
+    Statistics m_statistics;
+    QList<Batch *> m_activeBatches;
+    QHash<Invalidatable *, Entries> m_pending[Invalidatable::StageCount];
+};
+
+#endif // INVALIDATIONSCHEDULER_H
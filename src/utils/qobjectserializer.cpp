@@ -14,6 +14,7 @@
 #include "qobjectserializer.h"
 #include "timeprofiler.h"
 
+#include <QHash>
 #include <QtDebug>
 #include <QStack>
 #include <QColor>
@@ -22,6 +23,7 @@
 #include <QMetaObject>
 #include <QMetaProperty>
 #include <QMetaClassInfo>
+#include <QReadWriteLock>
 #include <QJsonDocument>
 #include <QQmlListProperty>
 #include <QQmlListReference>
@@ -138,58 +140,113 @@ const QObjectSerializer::Helper *ObjectSerializerHelperRegistry::findHelper(int
 
 Q_GLOBAL_STATIC(ObjectSerializerHelperRegistry, Helpers)
 
-void QObjectSerializer::registerHelper(QObjectSerializer::Helper *helper)
+/**
+ * A serialization plan captures everything about a class's properties that does not
+ * change from one instance to another. It is computed once per QMetaObject, so that
+ * serializing thousands of objects of the same class doesn't involve looking up
+ * property names, type names and helpers over and over again.
+ */
+struct ObjectSerializationPlan
 {
-    if (::Helpers()->contains(helper))
-        return;
+    struct Property
+    {
+        enum Kind { ListKind, EnumKind, FlagKind, ObjectKind, ValueKind };
+
+        Kind kind = ValueKind;
+        const QMetaObject *metaObject = nullptr; // Class that declares this property
+        QMetaProperty property;
+        QString name;
+        int userType = QMetaType::UnknownType;
+        const QObjectSerializer::Helper *helper = nullptr;
+
+        // For ListKind
+        const QMetaObject *listElementType = nullptr;
+        QByteArray listElementClassName;
+
+        // For ObjectKind
+        const QMetaObject *objectType = nullptr;
+        QByteArray objectClassName;
+    };
 
-    ::Helpers()->append(helper);
-}
+    QVector<Property> properties;
 
-QObjectSerializer::Helper::~Helper()
+    static const ObjectSerializationPlan *of(const QObject *object);
+    static void invalidateAll();
+
+    static QQmlListProperty<QObject> listProperty(const Property &property, QObject *object)
+    {
+        // This is exactly what QQmlListReference does, minus looking up the
+        // property by name.
+        QQmlListProperty<QObject> ret;
+        void *args[] = { &ret, nullptr };
+        QMetaObject::metacall(object, QMetaObject::ReadProperty, property.property.propertyIndex(),
+                              args);
+        return ret;
+    }
+
+private:
+    explicit ObjectSerializationPlan(const QObject *object);
+};
+
+class ObjectSerializationPlanRegistry : public QHash<const QMetaObject *, ObjectSerializationPlan *>
 {
-    ::Helpers()->removeOne(this);
-}
+public:
+    ~ObjectSerializationPlanRegistry() { qDeleteAll(*this); }
 
-QObjectSerializer::Interface::~Interface() { }
+    QReadWriteLock lock;
+};
 
-QJsonObject QObjectSerializer::toJson(const QObject *object)
+Q_GLOBAL_STATIC(ObjectSerializationPlanRegistry, SerializationPlans)
+
+const ObjectSerializationPlan *ObjectSerializationPlan::of(const QObject *object)
 {
-    QJsonObject ret;
-    if (object == nullptr)
-        return ret;
+    const QMetaObject *mo = object->metaObject();
+    ObjectSerializationPlanRegistry *plans = ::SerializationPlans();
 
-    QObjectSerializer::Interface *interface = qobject_cast<QObjectSerializer::Interface *>(object);
-    if (interface != nullptr)
-        interface->prepareForSerialization();
+    {
+        QReadLocker locker(&plans->lock);
+        const ObjectSerializationPlan *plan = plans->value(mo);
+        if (plan != nullptr)
+            return plan;
+    }
+
+    QWriteLocker locker(&plans->lock);
+    ObjectSerializationPlan *plan = plans->value(mo);
+    if (plan == nullptr) {
+        plan = new ObjectSerializationPlan(object);
+        plans->insert(mo, plan);
+    }
+
+    return plan;
+}
 
+void ObjectSerializationPlan::invalidateAll()
+{
+    if (::SerializationPlans.isDestroyed())
+        return;
+
+    ObjectSerializationPlanRegistry *plans = ::SerializationPlans();
+
+    QWriteLocker locker(&plans->lock);
+    qDeleteAll(*plans);
+    plans->clear();
+}
+
+ObjectSerializationPlan::ObjectSerializationPlan(const QObject *object)
+{
     QStack<const QMetaObject *> metaObjects;
-    QStringList classNames;
     const QMetaObject *mo = object->metaObject();
     while (mo) {
         metaObjects.push(mo);
-        if (interface != nullptr && interface->canSerialize(mo, QMetaProperty()) == false) {
-            mo = mo->superClass();
-            continue;
-        }
-
-        classNames << QString::fromLatin1(mo->className());
         mo = mo->superClass();
     }
 
-    // ret.insert("_class", classNames.join(","));
-
-    const QVariantMap defaultProperties =
-            QObjectSerializer::cacheDefaultPropertyValues(object, true);
-
     while (!metaObjects.isEmpty()) {
         mo = metaObjects.pop();
 
         const int nrProperties = mo->propertyCount();
         for (int i = mo->propertyOffset(); i < nrProperties; i++) {
             const QMetaProperty prop = mo->property(i);
-            if (interface != nullptr && interface->canSerialize(mo, prop) == false)
-                continue;
 
 #ifdef QT_WIDGETS_LIB
             // QGraphicsObject::parent property returns a parent QGraphicsObject.
@@ -200,8 +257,6 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
                 continue;
 #endif
 
-            const QMetaType propType(prop.userType());
-
             // The objectName property wont be stored. In all my experiments so far,
             // storing objectName has turned out to be pointless.
             static const char *objectName = "objectName";
@@ -219,54 +274,132 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
             // cant be unserialized, whats the point of storing them.
             // The only exception to this rule is if the property is returning a QObject
             // type. In which case, we have to serialize it.
+            const QMetaType propType(prop.userType());
             const bool isQObjectPointer = (propType.flags() & QMetaType::PointerToQObject);
             const bool isQQmlListProperty =
                     QByteArray(prop.typeName()).startsWith("QQmlListProperty");
             if (!prop.isWritable() && !isQObjectPointer && !isQQmlListProperty)
                 continue;
 
-            const QString propName = QString::fromLatin1(prop.name());
-            const QVariant defaultPropValue = defaultProperties.value(propName);
-            QVariant propValue = prop.read(object);
+            Property property;
+            property.metaObject = mo;
+            property.property = prop;
+            property.name = QString::fromLatin1(prop.name());
+            property.userType = prop.userType();
 
             if (isQQmlListProperty) {
-                QJsonArray list;
+                property.kind = Property::ListKind;
 
                 QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
-                for (int i = 0; i < listRef.count(); i++) {
-                    const QObject *listItem = listRef.at(i);
-                    if (listItem == nullptr)
-                        continue;
+                property.listElementType = listRef.listElementType();
+                if (property.listElementType != nullptr)
+                    property.listElementClassName =
+                            QByteArray(property.listElementType->className());
+            } else if (prop.isEnumType())
+                property.kind = Property::EnumKind;
+            else if (prop.isFlagType())
+                property.kind = Property::FlagKind;
+            else if (isQObjectPointer) {
+                property.kind = Property::ObjectKind;
+                property.objectType = QMetaType::metaObjectForType(prop.userType());
+                property.objectClassName = QByteArray(prop.typeName()).replace('*', "");
+            } else {
+                property.kind = Property::ValueKind;
+                property.helper = ::Helpers()->findHelper(prop.userType());
+            }
 
-                    QJsonObject item = QObjectSerializer::toJson(listItem);
-                    list.append(item);
-                }
+            this->properties.append(property);
+        }
+    }
+}
 
-                ret.insert(propName, list);
-            } else if (prop.isEnumType()) {
-                const QMetaEnum propEnum = prop.enumerator();
-                propValue = QString::fromLatin1(propEnum.valueToKey(propValue.toInt()));
-                if (defaultPropValue == propValue.toString())
-                    continue;
+void QObjectSerializer::registerHelper(QObjectSerializer::Helper *helper)
+{
+    if (::Helpers()->contains(helper))
+        return;
 
-                ret.insert(propName, propValue.toString());
-            } else if (prop.isFlagType()) {
-                const QMetaEnum propEnum = prop.enumerator();
-                propValue = QString::fromLatin1(propEnum.valueToKeys(propValue.toInt()));
-                if (defaultPropValue == propValue.toString())
+    ::Helpers()->append(helper);
+    ObjectSerializationPlan::invalidateAll();
+}
+
+QObjectSerializer::Helper::~Helper()
+{
+    ::Helpers()->removeOne(this);
+    ObjectSerializationPlan::invalidateAll();
+}
+
+QObjectSerializer::Interface::~Interface() { }
+
+QJsonObject QObjectSerializer::toJson(const QObject *object)
+{
+    PROFILE_THIS_FUNCTION;
+
+    QJsonObject ret;
+    if (object == nullptr)
+        return ret;
+
+    QObjectSerializer::Interface *interface = qobject_cast<QObjectSerializer::Interface *>(object);
+    if (interface != nullptr)
+        interface->prepareForSerialization();
+
+    const QVariantMap defaultProperties =
+            QObjectSerializer::cacheDefaultPropertyValues(object, true);
+
+    const ObjectSerializationPlan *plan = ObjectSerializationPlan::of(object);
+    for (const ObjectSerializationPlan::Property &planProp : plan->properties) {
+        const QMetaProperty &prop = planProp.property;
+        if (interface != nullptr && interface->canSerialize(planProp.metaObject, prop) == false)
+            continue;
+
+        const QString &propName = planProp.name;
+
+        switch (planProp.kind) {
+        case ObjectSerializationPlan::Property::ListKind: {
+            QJsonArray list;
+
+            QQmlListProperty<QObject> listProp =
+                    ObjectSerializationPlan::listProperty(planProp, const_cast<QObject *>(object));
+            const int listCount =
+                    listProp.count && listProp.at ? listProp.count(&listProp) : 0;
+            for (int i = 0; i < listCount; i++) {
+                const QObject *listItem = listProp.at(&listProp, i);
+                if (listItem == nullptr)
                     continue;
 
-                ret.insert(propName, propValue.toString());
-            } else if (propType.flags() & QMetaType::PointerToQObject) {
-                propValue.convert(QMetaType::QObjectStar);
+                QJsonObject item = QObjectSerializer::toJson(listItem);
+                list.append(item);
+            }
 
-                const QObject *propObject = propValue.value<QObject *>();
-                if (propObject != nullptr) {
-                    const QJsonObject propJson = QObjectSerializer::toJson(propObject);
-                    if (!propJson.isEmpty())
-                        ret.insert(propName, propJson);
-                }
-            } else if (propValue.userType() == QMetaType::QJsonValue) {
+            ret.insert(propName, list);
+        } break;
+        case ObjectSerializationPlan::Property::EnumKind:
+        case ObjectSerializationPlan::Property::FlagKind: {
+            const QMetaEnum propEnum = prop.enumerator();
+            const int value = prop.read(object).toInt();
+            const QString key = planProp.kind == ObjectSerializationPlan::Property::EnumKind
+                    ? QString::fromLatin1(propEnum.valueToKey(value))
+                    : QString::fromLatin1(propEnum.valueToKeys(value));
+            if (defaultProperties.value(propName) == key)
+                continue;
+
+            ret.insert(propName, key);
+        } break;
+        case ObjectSerializationPlan::Property::ObjectKind: {
+            QVariant propValue = prop.read(object);
+            propValue.convert(QMetaType::QObjectStar);
+
+            const QObject *propObject = propValue.value<QObject *>();
+            if (propObject != nullptr) {
+                const QJsonObject propJson = QObjectSerializer::toJson(propObject);
+                if (!propJson.isEmpty())
+                    ret.insert(propName, propJson);
+            }
+        } break;
+        case ObjectSerializationPlan::Property::ValueKind: {
+            const QVariant defaultPropValue = defaultProperties.value(propName);
+            const QVariant propValue = prop.read(object);
+
+            if (propValue.userType() == QMetaType::QJsonValue) {
                 const QJsonValue propJsonValue = propValue.toJsonValue();
                 if (defaultPropValue.toJsonValue() == propValue.toJsonValue())
                     continue;
@@ -284,21 +417,19 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
                     continue;
 
                 ret.insert(propName, propJsonArray);
-            } else {
-                const QObjectSerializer::Helper *helper = ::Helpers()->findHelper(prop.userType());
-                if (helper == nullptr) {
-                    if (propValue == defaultPropValue)
-                        continue;
+            } else if (planProp.helper == nullptr) {
+                if (propValue == defaultPropValue)
+                    continue;
 
-                    ret.insert(propName, QJsonValue::fromVariant(propValue));
-                } else {
-                    const QJsonValue propJsonValue = helper->toJson(propValue);
-                    if (propJsonValue == defaultPropValue.toJsonValue())
-                        continue;
+                ret.insert(propName, QJsonValue::fromVariant(propValue));
+            } else {
+                const QJsonValue propJsonValue = planProp.helper->toJson(propValue);
+                if (propJsonValue == defaultPropValue.toJsonValue())
+                    continue;
 
-                    ret.insert(propName, propJsonValue);
-                }
+                ret.insert(propName, propJsonValue);
             }
+        } break;
         }
     }
 
@@ -320,6 +451,8 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
 
 bool QObjectSerializer::fromJson(const QJsonObject &json, QObject *object, QObjectFactory *factory)
 {
+    PROFILE_THIS_FUNCTION;
+
     if (object == nullptr)
         return false;
 
@@ -330,133 +463,103 @@ bool QObjectSerializer::fromJson(const QJsonObject &json, QObject *object, QObje
     if (interface != nullptr)
         interface->prepareForDeserialization();
 
-    QStack<const QMetaObject *> metaObjects;
-    QStringList classNames;
-    const QMetaObject *mo = object->metaObject();
-    while (mo) {
-        metaObjects.push(mo);
-        if (interface != nullptr && interface->canSerialize(mo, QMetaProperty()) == false) {
-            mo = mo->superClass();
+    const ObjectSerializationPlan *plan = ObjectSerializationPlan::of(object);
+    for (const ObjectSerializationPlan::Property &planProp : plan->properties) {
+        const QMetaProperty &prop = planProp.property;
+        if (interface != nullptr && interface->canSerialize(planProp.metaObject, prop) == false)
             continue;
-        }
-
-        classNames << QString::fromLatin1(mo->className());
-        mo = mo->superClass();
-    }
-
-    while (!metaObjects.isEmpty()) {
-        mo = metaObjects.pop();
-
-        const int nrProperties = mo->propertyCount();
-        for (int i = mo->propertyOffset(); i < nrProperties; i++) {
-            const QMetaProperty prop = mo->property(i);
-            if (interface != nullptr && interface->canSerialize(mo, prop) == false)
-                continue;
-
-            const QMetaType propType(prop.userType());
-
-            static const char *objectName = "objectName";
-            if (!qstrcmp(prop.name(), objectName))
-                continue;
-
-            if (!prop.isStored())
-                continue;
-
-            const bool isQObjectPointer = (propType.flags() & QMetaType::PointerToQObject);
-            const bool isQQmlListProperty =
-                    QByteArray(prop.typeName()).startsWith("QQmlListProperty");
-            if (!prop.isWritable() && !isQObjectPointer && !isQQmlListProperty)
-                continue;
 
-            const QString propName = QString::fromLatin1(prop.name());
-            if (!json.contains(propName))
-                continue;
-
-            const QJsonValue jsonPropValue = json.value(propName);
-
-            if (isQQmlListProperty) {
-                const QJsonArray list = jsonPropValue.toArray();
+        const QString &propName = planProp.name;
+        const QJsonObject::const_iterator jsonIt = json.constFind(propName);
+        if (jsonIt == json.constEnd())
+            continue;
 
-                QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
-                const bool canAddObjects =
-                        interface && interface->canSetPropertyFromObjectList(propName)
-                        && listRef.canAppend();
-
-                QObjectFactory listItemFactory;
-                const QByteArray className(listRef.listElementType()->className());
-                listItemFactory.add(listRef.listElementType());
-
-                QList<QObject *> propertyObjects;
-                if (canAddObjects)
-                    propertyObjects.reserve(list.size());
-                else if (listRef.canAppend())
-                    listRef.clear();
-
-                for (int i = 0; i < list.size(); i++) {
-                    const QJsonObject listItem = list.at(i).toObject();
-
-                    if (listRef.canAppend()) {
-                        QObject *listItemObject =
-                                listItemFactory.create(className, listRef.object());
-                        QObjectSerializer::fromJson(listItem, listItemObject, factory);
-                        if (canAddObjects)
-                            propertyObjects.append(listItemObject);
-                        else
-                            listRef.append(listItemObject);
-                    } else {
-                        QObject *listItemObject = listRef.at(i);
-                        if (listItemObject == nullptr)
-                            continue;
-                        QObjectSerializer::fromJson(listItem, listItemObject, factory);
-                    }
+        const QJsonValue jsonPropValue = jsonIt.value();
+
+        switch (planProp.kind) {
+        case ObjectSerializationPlan::Property::ListKind: {
+            const QJsonArray list = jsonPropValue.toArray();
+
+            QQmlListProperty<QObject> listProp =
+                    ObjectSerializationPlan::listProperty(planProp, object);
+            const bool canAppend = listProp.object != nullptr && listProp.append != nullptr;
+            const bool canAddObjects =
+                    interface && interface->canSetPropertyFromObjectList(propName) && canAppend;
+
+            QObjectFactory listItemFactory;
+            if (planProp.listElementType != nullptr)
+                listItemFactory.add(planProp.listElementType);
+
+            QList<QObject *> propertyObjects;
+            if (canAddObjects)
+                propertyObjects.reserve(list.size());
+            else if (canAppend && listProp.clear != nullptr)
+                listProp.clear(&listProp);
+
+            const int listCount = canAppend || listProp.count == nullptr
+                    ? 0
+                    : listProp.count(&listProp);
+
+            for (int i = 0; i < list.size(); i++) {
+                const QJsonObject listItem = list.at(i).toObject();
+
+                if (canAppend) {
+                    QObject *listItemObject =
+                            listItemFactory.create(planProp.listElementClassName, listProp.object);
+                    QObjectSerializer::fromJson(listItem, listItemObject, factory);
+                    if (canAddObjects)
+                        propertyObjects.append(listItemObject);
+                    else
+                        listProp.append(&listProp, listItemObject);
+                } else {
+                    QObject *listItemObject =
+                            i < listCount && listProp.at ? listProp.at(&listProp, i) : nullptr;
+                    if (listItemObject == nullptr)
+                        continue;
+                    QObjectSerializer::fromJson(listItem, listItemObject, factory);
                 }
-
-                if (canAddObjects)
-                    interface->setPropertyFromObjectList(propName, propertyObjects);
-
-                continue;
             }
 
-            if (prop.isEnumType() || prop.isFlagType()) {
-                const QByteArray key = jsonPropValue.toString().toLatin1();
-                const QMetaEnum enumerator = prop.enumerator();
-                const int value = prop.isFlagType()
-                        ? (key.isEmpty() ? 0 : enumerator.keysToValue(key))
-                        : enumerator.keyToValue(key);
-                prop.write(object, value);
-                continue;
-            }
+            if (canAddObjects)
+                interface->setPropertyFromObjectList(propName, propertyObjects);
+        } break;
+        case ObjectSerializationPlan::Property::EnumKind:
+        case ObjectSerializationPlan::Property::FlagKind: {
+            const QByteArray key = jsonPropValue.toString().toLatin1();
+            const QMetaEnum enumerator = prop.enumerator();
+            const int value = prop.isFlagType()
+                    ? (key.isEmpty() ? 0 : enumerator.keysToValue(key))
+                    : enumerator.keyToValue(key);
+            prop.write(object, value);
+        } break;
+        case ObjectSerializationPlan::Property::ObjectKind: {
+            QObjectFactory *usableFactory = factory;
+            QObjectFactory stopGapFactory;
 
-            if (propType.flags() & QMetaType::PointerToQObject) {
-                QObjectFactory *usableFactory = factory;
-                QObjectFactory stopGapFactory;
-
-                const QVariant propValue = prop.read(object);
-                QObject *propObject = propValue.value<QObject *>();
-                if (propObject == nullptr) {
-                    if (factory == nullptr) {
-                        stopGapFactory.add(QMetaType::metaObjectForType(prop.userType()));
-                        usableFactory = &stopGapFactory;
-                    } else
-                        factory->add(QMetaType::metaObjectForType(prop.userType()));
-
-                    if (prop.isWritable() && usableFactory != nullptr) {
-                        const QByteArray className = QByteArray(prop.typeName()).replace('*', "");
-                        propObject = usableFactory->create(className, object);
-                        if (propObject == nullptr)
-                            continue;
-
-                        prop.write(object, QVariant::fromValue(propObject));
-                    } else
+            const QVariant propValue = prop.read(object);
+            QObject *propObject = propValue.value<QObject *>();
+            if (propObject == nullptr) {
+                if (factory == nullptr) {
+                    stopGapFactory.add(planProp.objectType);
+                    usableFactory = &stopGapFactory;
+                } else
+                    factory->add(planProp.objectType);
+
+                if (prop.isWritable() && usableFactory != nullptr) {
+                    propObject = usableFactory->create(planProp.objectClassName, object);
+                    if (propObject == nullptr)
                         continue;
-                }
 
-                const QJsonObject propJson = jsonPropValue.toObject();
-                QObjectSerializer::fromJson(propJson, propObject, usableFactory);
-                continue;
+                    prop.write(object, QVariant::fromValue(propObject));
+                } else
+                    continue;
             }
 
-            switch (prop.userType()) {
+            const QJsonObject propJson = jsonPropValue.toObject();
+            QObjectSerializer::fromJson(propJson, propObject, usableFactory);
+        } break;
+        case ObjectSerializationPlan::Property::ValueKind: {
+            switch (planProp.userType) {
             case QMetaType::QJsonValue:
                 prop.write(object, QVariant::fromValue<QJsonValue>(jsonPropValue));
                 continue;
@@ -470,12 +573,11 @@ bool QObjectSerializer::fromJson(const QJsonObject &json, QObject *object, QObje
                 break;
             }
 
-            const QObjectSerializer::Helper *helper = ::Helpers()->findHelper(prop.userType());
-            const QJsonValue propJsonValue = json.value(propName);
-            const QVariant propValue = helper == nullptr
-                    ? propJsonValue.toVariant()
-                    : helper->fromJson(propJsonValue, prop.userType());
+            const QVariant propValue = planProp.helper == nullptr
+                    ? jsonPropValue.toVariant()
+                    : planProp.helper->fromJson(jsonPropValue, planProp.userType);
             prop.write(object, propValue);
+        } break;
         }
     }
 
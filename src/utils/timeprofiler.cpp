@@ -0,0 +1,301 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "timeprofiler.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QCoreApplication>
+
+#include <algorithm>
+
+std::atomic<bool> TimeProfiler::enabledFlag(qgetenv("SCRITE_PROFILER").toUpper().trimmed()
+                                             == QByteArrayLiteral("YES"));
+
+/**
+ * Sites are kept in an intrusive singly linked list. Sites are only ever added,
+ * and they live until the process exits, so a CAS on the head is all we need.
+ */
+static std::atomic<TimeProfilerSite *> TimeProfilerSites(nullptr);
+
+TimeProfilerSite::TimeProfilerSite(const char *name) : m_name(name)
+{
+    TimeProfilerSite *head = TimeProfilerSites.load(std::memory_order_relaxed);
+    do {
+        m_next = head;
+    } while (!TimeProfilerSites.compare_exchange_weak(head, this, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+}
+
+void TimeProfilerSite::record(qint64 durationNs)
+{
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+
+    qint64 min = m_minNs.load(std::memory_order_relaxed);
+    while (durationNs < min
+           && !m_minNs.compare_exchange_weak(min, durationNs, std::memory_order_relaxed))
+        ;
+
+    qint64 max = m_maxNs.load(std::memory_order_relaxed);
+    while (durationNs > max
+           && !m_maxNs.compare_exchange_weak(max, durationNs, std::memory_order_relaxed))
+        ;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct TimeProfilerEvent
+{
+    const TimeProfilerSite *site = nullptr;
+    qint64 startNs = 0;
+    qint64 durationNs = 0;
+};
+
+/**
+ * Each thread that records an event gets its own ring buffer. Only the owning
+ * thread writes into it, so pushing an event is a plain store followed by a
+ * release-store of the head. Readers (dumpTrace) copy the ring and then discard
+ * whatever may have been overwritten while they were copying.
+ */
+class TimeProfilerThreadBuffer
+{
+public:
+    enum { Capacity = 1 << 15 };
+
+    explicit TimeProfilerThreadBuffer(int id) : m_id(id)
+    {
+        QThread *thread = QThread::currentThread();
+        if (thread != nullptr) {
+            m_name = thread->objectName();
+            if (m_name.isEmpty() && qApp && thread == qApp->thread())
+                m_name = QStringLiteral("Main Thread");
+            else if (m_name.isEmpty())
+                m_name = QString::fromLatin1(thread->metaObject()->className());
+        }
+    }
+
+    int id() const { return m_id; }
+    QString name() const { return m_name; }
+
+    void push(const TimeProfilerEvent &event)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        m_events[head & (Capacity - 1)] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    QVector<TimeProfilerEvent> snapshot() const
+    {
+        const quint64 end = m_head.load(std::memory_order_acquire);
+        quint64 begin = end > Capacity ? end - Capacity : 0;
+
+        QVector<TimeProfilerEvent> ret;
+        ret.reserve(int(end - begin));
+        for (quint64 i = begin; i < end; i++)
+            ret.append(m_events[i & (Capacity - 1)]);
+
+        // Drop events that the owning thread may have overwritten meanwhile.
+        const quint64 now = m_head.load(std::memory_order_acquire);
+        const quint64 safeBegin = now > Capacity ? now - Capacity : 0;
+        if (safeBegin > begin)
+            ret.remove(0, int(qMin(safeBegin - begin, quint64(ret.size()))));
+
+        return ret;
+    }
+
+    void clear() { m_head.store(0, std::memory_order_release); }
+
+private:
+    int m_id = 0;
+    QString m_name;
+    std::atomic<quint64> m_head { 0 };
+    TimeProfilerEvent m_events[Capacity];
+};
+
+struct TimeProfilerData
+{
+    QElapsedTimer clock;
+    QMutex buffersMutex; // taken only once per thread, and while dumping
+    QList<TimeProfilerThreadBuffer *> buffers;
+
+    TimeProfilerData() { clock.start(); }
+    ~TimeProfilerData() { qDeleteAll(buffers); }
+
+    TimeProfilerThreadBuffer *createBuffer()
+    {
+        QMutexLocker locker(&buffersMutex);
+        TimeProfilerThreadBuffer *buffer = new TimeProfilerThreadBuffer(buffers.size() + 1);
+        buffers.append(buffer);
+        return buffer;
+    }
+};
+Q_GLOBAL_STATIC(TimeProfilerData, ProfilerData)
+
+static TimeProfilerThreadBuffer *currentThreadBuffer()
+{
+    // Buffers are owned by ProfilerData and outlive the thread, so that events
+    // from short-lived worker threads show up in the trace as well.
+    if (ProfilerData.isDestroyed())
+        return nullptr;
+
+    thread_local TimeProfilerThreadBuffer *buffer = nullptr;
+    if (buffer == nullptr)
+        buffer = ProfilerData->createBuffer();
+    return buffer;
+}
+
+void TimeProfiler::setEnabled(bool val)
+{
+    enabledFlag.store(val, std::memory_order_relaxed);
+}
+
+qint64 TimeProfiler::now()
+{
+    if (ProfilerData.isDestroyed())
+        return 0;
+    return ProfilerData->clock.nsecsElapsed();
+}
+
+void TimeProfiler::record(TimeProfilerSite *site, qint64 startNs, qint64 endNs)
+{
+    if (site == nullptr)
+        return;
+
+    const qint64 durationNs = qMax(endNs - startNs, qint64(0));
+    site->record(durationNs);
+
+    TimeProfilerThreadBuffer *buffer = ::currentThreadBuffer();
+    if (buffer != nullptr)
+        buffer->push({ site, startNs, durationNs });
+}
+
+QList<TimeProfiler::Statistics> TimeProfiler::statistics()
+{
+    QList<Statistics> ret;
+
+    TimeProfilerSite *site = TimeProfilerSites.load(std::memory_order_acquire);
+    while (site != nullptr) {
+        const qint64 count = site->m_count.load(std::memory_order_relaxed);
+        if (count > 0) {
+            Statistics stats;
+            stats.function = QString::fromLatin1(site->name());
+            stats.count = count;
+            stats.totalNs = site->m_totalNs.load(std::memory_order_relaxed);
+            stats.minNs = site->m_minNs.load(std::memory_order_relaxed);
+            stats.maxNs = site->m_maxNs.load(std::memory_order_relaxed);
+            stats.avgNs = stats.totalNs / count;
+            ret.append(stats);
+        }
+        site = site->m_next;
+    }
+
+    std::sort(ret.begin(), ret.end(), [](const Statistics &a, const Statistics &b) {
+        return a.totalNs > b.totalNs;
+    });
+
+    return ret;
+}
+
+QString TimeProfiler::statisticsReport()
+{
+    const QList<Statistics> stats = TimeProfiler::statistics();
+    if (stats.isEmpty())
+        return QString();
+
+    auto ms = [](qint64 ns) { return QString::number(double(ns) / 1e6, 'f', 3); };
+
+    QStringList lines;
+    lines << QStringLiteral("Count\tTotal(ms)\tMin(ms)\tAvg(ms)\tMax(ms)\tFunction");
+    for (const Statistics &s : stats)
+        lines << QString::number(s.count) + "\t" + ms(s.totalNs) + "\t" + ms(s.minNs) + "\t"
+                        + ms(s.avgNs) + "\t" + ms(s.maxNs) + "\t" + s.function;
+    return lines.join("\n");
+}
+
+bool TimeProfiler::dumpTrace(const QString &fileName)
+{
+    if (ProfilerData.isDestroyed())
+        return false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QList<TimeProfilerThreadBuffer *> buffers;
+    {
+        QMutexLocker locker(&ProfilerData->buffersMutex);
+        buffers = ProfilerData->buffers;
+    }
+
+    QJsonArray traceEvents;
+    for (const TimeProfilerThreadBuffer *buffer : qAsConst(buffers)) {
+        QJsonObject threadName;
+        threadName.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+        threadName.insert(QStringLiteral("ph"), QStringLiteral("M"));
+        threadName.insert(QStringLiteral("pid"), pid);
+        threadName.insert(QStringLiteral("tid"), buffer->id());
+        threadName.insert(QStringLiteral("args"),
+                          QJsonObject({ { QStringLiteral("name"), buffer->name() } }));
+        traceEvents.append(threadName);
+
+        const QVector<TimeProfilerEvent> events = buffer->snapshot();
+        for (const TimeProfilerEvent &event : events) {
+            QJsonObject item;
+            item.insert(QStringLiteral("name"), QString::fromLatin1(event.site->name()));
+            item.insert(QStringLiteral("cat"), QStringLiteral("scrite"));
+            item.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            item.insert(QStringLiteral("ts"), double(event.startNs) / 1000.0);
+            item.insert(QStringLiteral("dur"), double(event.durationNs) / 1000.0);
+            item.insert(QStringLiteral("pid"), pid);
+            item.insert(QStringLiteral("tid"), buffer->id());
+            traceEvents.append(item);
+        }
+    }
+
+    QJsonObject trace;
+    trace.insert(QStringLiteral("traceEvents"), traceEvents);
+    trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void TimeProfiler::reset()
+{
+    TimeProfilerSite *site = TimeProfilerSites.load(std::memory_order_acquire);
+    while (site != nullptr) {
+        site->m_count.store(0, std::memory_order_relaxed);
+        site->m_totalNs.store(0, std::memory_order_relaxed);
+        site->m_minNs.store(std::numeric_limits<qint64>::max(), std::memory_order_relaxed);
+        site->m_maxNs.store(0, std::memory_order_relaxed);
+        site = site->m_next;
+    }
+
+    if (ProfilerData.isDestroyed())
+        return;
+
+    QMutexLocker locker(&ProfilerData->buffersMutex);
+    for (TimeProfilerThreadBuffer *buffer : qAsConst(ProfilerData->buffers))
+        buffer->clear();
+}
@@ -14,7 +14,99 @@
 #ifndef TIME_PROFILER_H
 #define TIME_PROFILER_H
 
-#define PROFILE_THIS_FUNCTION
-#define PROFILE_THIS_FUNCTION2
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <limits>
+
+/**
+ * One instance of this class is created (as a function local static) for every
+ * place where PROFILE_THIS_FUNCTION is used. It aggregates call count and
+ * min/max/total time spent using atomics, so recording from multiple threads
+ * never takes a lock.
+ */
+class TimeProfilerSite
+{
+public:
+    explicit TimeProfilerSite(const char *name);
+
+    const char *name() const { return m_name; }
+
+    void record(qint64 durationNs);
+
+private:
+    friend class TimeProfiler;
+    const char *m_name = nullptr;
+    TimeProfilerSite *m_next = nullptr;
+    std::atomic<qint64> m_count { 0 };
+    std::atomic<qint64> m_totalNs { 0 };
+    std::atomic<qint64> m_minNs { std::numeric_limits<qint64>::max() };
+    std::atomic<qint64> m_maxNs { 0 };
+};
+
+class TimeProfiler
+{
+public:
+    // Profiling is off by default. It can be switched on by setting the
+    // SCRITE_PROFILER environment variable to YES, or from Application.
+    static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool val);
+
+    // Nanoseconds elapsed since the profiler clock was started.
+    static qint64 now();
+
+    static void record(TimeProfilerSite *site, qint64 startNs, qint64 endNs);
+
+    struct Statistics
+    {
+        QString function;
+        qint64 count = 0;
+        qint64 minNs = 0;
+        qint64 avgNs = 0;
+        qint64 maxNs = 0;
+        qint64 totalNs = 0;
+    };
+    static QList<Statistics> statistics();
+    static QString statisticsReport();
+
+    // Writes events captured so far, in Chrome trace-event JSON format, to the
+    // given file. The file can be loaded in chrome://tracing or Perfetto.
+    static bool dumpTrace(const QString &fileName);
+
+    static void reset();
+
+private:
+    static std::atomic<bool> enabledFlag;
+};
+
+class TimeProfilerScope
+{
+public:
+    explicit TimeProfilerScope(TimeProfilerSite *site)
+        : m_site(TimeProfiler::isEnabled() ? site : nullptr)
+    {
+        if (m_site != nullptr)
+            m_startNs = TimeProfiler::now();
+    }
+    ~TimeProfilerScope()
+    {
+        if (m_site != nullptr)
+            TimeProfiler::record(m_site, m_startNs, TimeProfiler::now());
+    }
+
+private:
+    TimeProfilerSite *m_site = nullptr;
+    qint64 m_startNs = 0;
+};
+
+#define PROFILE_THIS_FUNCTION                                                                      \
+    static TimeProfilerSite timeProfilerSite(Q_FUNC_INFO);                                         \
+    TimeProfilerScope timeProfilerScope(&timeProfilerSite)
+
+// For use in a nested block of a function already profiled with PROFILE_THIS_FUNCTION
+#define PROFILE_THIS_FUNCTION2                                                                     \
+    static TimeProfilerSite timeProfilerSite2(Q_FUNC_INFO);                                        \
+    TimeProfilerScope timeProfilerScope2(&timeProfilerSite2)
 
 #endif // TIME_PROFILER_H